@@ -0,0 +1,56 @@
+/**
+ ******************************************************************************
+ * @file    spi.h
+ * @brief   This file contains all the function prototypes for
+ *          the spi.c file
+ ******************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; Copyright (c) 2021 STMicroelectronics.
+ * All rights reserved.</center></h2>
+ *
+ * This software component is licensed by ST under BSD 3-Clause license,
+ * the "License"; You may not use this file except in compliance with the
+ * License. You may obtain a copy of the License at:
+ *                        opensource.org/licenses/BSD-3-Clause
+ *
+ ******************************************************************************
+ */
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __SPI_H__
+#define __SPI_H__
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "main.h"
+
+    /* USER CODE BEGIN Includes */
+
+    /* USER CODE END Includes */
+
+    extern SPI_HandleTypeDef hspi2;
+    extern DMA_HandleTypeDef hdma_spi2_tx;
+
+    /* USER CODE BEGIN Private defines */
+
+    /* USER CODE END Private defines */
+
+    void MX_SPI2_Init(void);
+
+    /* USER CODE BEGIN Prototypes */
+
+    /* Defined in Project/LcdSpiTransport.cpp: calls LcdSpiTransport::tx_complete(). */
+    void lcd_spi_tx_complete(SPI_HandleTypeDef* hspi);
+
+    /* USER CODE END Prototypes */
+
+#ifdef __cplusplus
+}
+#endif
+#endif /*__ SPI_H__ */
+
+/************************ (C) COPYRIGHT STMicroelectronics *****END OF FILE****/
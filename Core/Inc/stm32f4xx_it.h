@@ -57,6 +57,7 @@ extern "C"
     void DebugMon_Handler(void);
     void PendSV_Handler(void);
     void SysTick_Handler(void);
+    void DMA1_Stream4_IRQHandler(void);
     /* USER CODE BEGIN EFP */
 
     /* USER CODE END EFP */
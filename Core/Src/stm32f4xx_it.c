@@ -23,6 +23,9 @@
 #include "main.h"
 #include "Project/projectMain.h"
 
+/* External variables --------------------------------------------------------*/
+extern DMA_HandleTypeDef hdma_spi2_tx;
+
 /******************************************************************************/
 /*           Cortex-M4 Processor Interruption and Exception Handlers          */
 /******************************************************************************/
@@ -159,6 +162,14 @@ void SysTick_Handler(void)
 /* please refer to the startup file (startup_stm32f4xx.s).                    */
 /******************************************************************************/
 
+/**
+ * @brief This function handles DMA1 stream4 global interrupt (SPI2_TX).
+ */
+void DMA1_Stream4_IRQHandler(void)
+{
+    HAL_DMA_IRQHandler(&hdma_spi2_tx);
+}
+
 /* USER CODE BEGIN 1 */
 
 /* USER CODE END 1 */
@@ -0,0 +1,389 @@
+
+/**
+ * @file lcd_bench.cpp
+ * @brief Microbenchmarks of the rendering kernels of LcdDriver.
+ *
+ * Times blit, print_buffer, print, put_char_xy, clear_area, invert_rect and refresh_screen for every font of font.h and every y%8 alignment, with the bus
+ * replaced by LcdCountingTransport. Each case is calibrated to run for at least the minimum time,
+ * then measured several times; the fastest run is reported, which filters out scheduler noise.
+ *
+ * Usage: lcd-bench [--quick] [--out results.json]
+ *
+ * The results are written as JSON (to stdout without --out):
+ * {
+ *   "benchmark": "lcd-bench",
+ *   "results": [
+ *     {"kernel": "print_buffer", "variant": "FontDefault", "y_align": 3, "unit": "glyph",
+ *      "ns_per_op": 41.2, "iterations": 131072, "bytes_per_frame": 34},
+ *     ...
+ *   ]
+ * }
+ * "variant" is the font, custom character or area size. "unit" tells what one operation is:
+ * one glyph, one call or one full frame. "bytes_per_frame" is what the call puts on the bus with
+ * the PerCall flush policy (commands and data), or null for kernels that never send.
+ *
+ * @author Ömer Gökyer
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "LcdCountingTransport.hpp"
+#include "LcdDriver.hpp"
+
+/**
+ * @brief Gives the benchmarks access to the private kernels of LcdDriver.
+ */
+class LcdDriverBench {
+
+    public:
+
+        static void blit(LcdDriver& lcd, uint8_t x, uint8_t y, const uint8_t* bitmap, uint8_t width, uint8_t height){
+
+            lcd.blit(x, y, bitmap, width, height, LcdRasterOp::Or);
+        }
+
+        static const uint8_t* buffer(const LcdDriver& lcd){
+
+            return lcd.buffer;
+        }
+};
+
+/**
+ * @brief One line of the report.
+ */
+struct BenchResult {
+
+    std::string kernel;
+    std::string variant;
+    int y_align;                /**< y % 8 of the case, -1 if the kernel has no alignment. */
+    const char* unit;
+    double ns_per_op;
+    uint64_t iterations;
+    long bytes_per_frame;       /**< -1 if the kernel does not send. */
+};
+
+static std::vector<BenchResult> results;
+static std::chrono::nanoseconds min_time{std::chrono::milliseconds(10)};
+static int repeats = 5;
+
+/* Keeps the compiler from dropping work whose result is only in memory. */
+static inline void keep(const void* p)
+{
+    asm volatile("" : : "r"(p) : "memory");
+}
+
+/**
+ * @brief Times an operation and returns the fastest ns per operation of several runs.
+ *
+ * @param op Callable that performs ops_per_call operations.
+ * @param ops_per_call How many operations (glyphs) one call of op performs.
+ * @param iterations Receives the number of calls per run.
+ */
+template <typename Op>
+static double measure(Op&& op, uint32_t ops_per_call, uint64_t& iterations)
+{
+    using clock = std::chrono::steady_clock;
+    iterations = 1;
+    for (;;)
+    {
+        clock::time_point start = clock::now();
+        for (uint64_t i = 0; i < iterations; i++)
+        {
+            op();
+        }
+        if (clock::now() - start >= min_time)
+        {
+            break;
+        }
+        iterations *= 2;
+    }
+
+    double best = 0;
+    for (int r = 0; r < repeats; r++)
+    {
+        clock::time_point start = clock::now();
+        for (uint64_t i = 0; i < iterations; i++)
+        {
+            op();
+        }
+        std::chrono::duration<double, std::nano> elapsed = clock::now() - start;
+        double ns = elapsed.count() / static_cast<double>(iterations * ops_per_call);
+        if (r == 0 || ns < best)
+        {
+            best = ns;
+        }
+    }
+    return best;
+}
+
+template <typename Op>
+static void run(const char* kernel, const std::string& variant, int y_align, const char* unit,
+                uint32_t ops_per_call, long bytes_per_frame, Op&& op)
+{
+    uint64_t iterations = 0;
+    double ns = measure(op, ops_per_call, iterations);
+    results.push_back(BenchResult{kernel, variant, y_align, unit, ns, iterations, bytes_per_frame});
+    fprintf(stderr, "%-18s %-18s y%%8=%-2d %10.1f ns/%s\n", kernel, variant.c_str(), y_align, ns, unit);
+}
+
+/**
+ * @brief Calls f(name, font) for every font of font.h.
+ */
+template <typename F>
+static void for_each_font(F&& f)
+{
+    f("FontDefault", FontDefault);
+    f("FontThick", FontThick);
+    f("FontHomeSpun", FontHomeSpun);
+    f("FontSevenSegment", FontSevenSegment);
+    f("FontWide", FontWide);
+    f("FontTiny", FontTiny);
+    f("Default", Default);
+    f("FontLarge", FontLarge);
+    f("FontHuge", FontHuge);
+    f("FontMega", FontMega);
+}
+
+/**
+ * @brief Builds a string of glyphs that exist in the font and fit on one line.
+ */
+template <typename Font>
+static std::string sample_text(const Font&)
+{
+    std::string text;
+    const size_t glyphs = static_cast<size_t>(Font::last - Font::first) + 1;
+    size_t count = (84 / Font::width < 10) ? 84 / Font::width : 10;
+    for (size_t i = 0; i < count; i++)
+    {
+        text += static_cast<char>(Font::first + 1 + (i + 15) % (glyphs - 1));
+    }
+    return text;
+}
+
+/**
+ * @brief Bytes one draw call puts on the bus with the PerCall flush policy.
+ */
+template <typename Draw>
+static long bytes_per_call(Draw&& draw)
+{
+    LcdCountingTransport bus;
+    LcdDriver lcd(bus);
+    lcd.init();
+    bus.reset();
+    draw(lcd);
+    return static_cast<long>(bus.total_bytes());
+}
+
+/* blit: the per glyph step of print_buffer. */
+template <typename Font>
+static void bench_blit(const char* name, const Font& font)
+{
+    LcdCountingTransport bus;
+    LcdDriver lcd(bus);
+    lcd.set_flush_policy(LcdFlushPolicy::Manual);
+    const uint8_t* glyph = font.glyph_bytes(sample_text(font)[0]);
+
+    for (uint8_t align = 0; align < 8; align++)
+    {
+        const uint8_t y = static_cast<uint8_t>(8 + align);
+        run("blit", name, align, "glyph", 1, -1, [&]
+        {
+            LcdDriverBench::blit(lcd, 0, y, glyph, Font::width, Font::height);
+            keep(LcdDriverBench::buffer(lcd));
+        });
+    }
+}
+
+/* print_buffer draws through the buffer. */
+template <typename Font>
+static void bench_print_buffer(const char* name, const Font& font)
+{
+    const std::string text = sample_text(font);
+    const uint32_t glyphs = static_cast<uint32_t>(text.size());
+    for (uint8_t align = 0; align < 8; align++)
+    {
+        const uint8_t y = static_cast<uint8_t>(8 + align);
+        long bytes = bytes_per_call([&](LcdDriver& lcd)
+        {
+            lcd.print_buffer(text.c_str(), 0, y, font);
+        });
+
+        LcdCountingTransport bus;
+        LcdDriver lcd(bus);
+        lcd.set_flush_policy(LcdFlushPolicy::Manual);
+        run("print_buffer", name, align, "glyph", glyphs, bytes, [&]
+        {
+            lcd.print_buffer(text.c_str(), 0, y, font);
+            keep(LcdDriverBench::buffer(lcd));
+        });
+    }
+}
+
+/* print writes straight to the LCD, one bank row per byte of the font. */
+template <typename Font>
+static void bench_print(const char* name, const Font& font)
+{
+    const std::string text = sample_text(font);
+    const uint32_t glyphs = static_cast<uint32_t>(text.size());
+    long bytes = bytes_per_call([&](LcdDriver& lcd)
+    {
+        lcd.print(text.c_str(), 0, 1, font);
+    });
+
+    LcdCountingTransport bus;
+    LcdDriver lcd(bus);
+    run("print", name, 0, "glyph", glyphs, bytes, [&]
+    {
+        lcd.print(text.c_str(), 0, 1, font);
+    });
+}
+
+static void bench_put_char_xy()
+{
+    for (uint8_t align = 0; align < 8; align++)
+    {
+        const uint8_t y = static_cast<uint8_t>(8 + align);
+        long bytes = bytes_per_call([&](LcdDriver& lcd)
+        {
+            lcd.put_char_xy(arrow_char, 20, y);
+        });
+
+        LcdCountingTransport bus;
+        LcdDriver lcd(bus);
+        lcd.set_flush_policy(LcdFlushPolicy::Manual);
+        run("put_char_xy", "arrow_char", align, "glyph", 1, bytes, [&]
+        {
+            lcd.put_char_xy(arrow_char, 20, y);
+            keep(LcdDriverBench::buffer(lcd));
+        });
+    }
+
+    long bytes = bytes_per_call([](LcdDriver& lcd)
+    {
+        lcd.put_char_xy(menu_gui, 0, 0);
+    });
+    LcdCountingTransport bus;
+    LcdDriver lcd(bus);
+    lcd.set_flush_policy(LcdFlushPolicy::Manual);
+    run("put_char_xy", "menu_gui", 0, "glyph", 1, bytes, [&]
+    {
+        lcd.put_char_xy(menu_gui, 0, 0);
+        keep(LcdDriverBench::buffer(lcd));
+    });
+}
+
+static void bench_rects()
+{
+    const uint8_t sizes[][2] = {{8, 8}, {84, 8}, {24, 16}};
+    for (const uint8_t* size : sizes)
+    {
+        const std::string variant = std::to_string(size[0]) + "x" + std::to_string(size[1]);
+        const uint8_t x = static_cast<uint8_t>((84 - size[0]) / 2);
+        for (uint8_t align = 0; align < 8; align++)
+        {
+            const uint8_t y = static_cast<uint8_t>(8 + align);
+            LcdCountingTransport bus;
+            LcdDriver lcd(bus);
+            lcd.set_flush_policy(LcdFlushPolicy::Manual);
+            run("clear_area", variant, align, "call", 1, -1, [&]
+            {
+                lcd.clear_area(x, y, size[0], size[1]);
+                keep(LcdDriverBench::buffer(lcd));
+            });
+            run("invert_rect", variant, align, "call", 1, -1, [&]
+            {
+                lcd.invert_rect(x, y, size[0], size[1]);
+                keep(LcdDriverBench::buffer(lcd));
+            });
+        }
+    }
+}
+
+static void bench_refresh_screen()
+{
+    long bytes = bytes_per_call([](LcdDriver& lcd)
+    {
+        lcd.refresh_screen();
+    });
+
+    LcdCountingTransport bus;
+    LcdDriver lcd(bus);
+    run("refresh_screen", "full", -1, "frame", 1, bytes, [&]
+    {
+        lcd.refresh_screen();
+    });
+}
+
+static void write_json(FILE* file)
+{
+    fprintf(file, "{\n  \"benchmark\": \"lcd-bench\",\n  \"framebuffers\": %d,\n  \"min_time_ms\": %lld,\n  \"results\": [\n",
+            LCD_FRAMEBUFFER_COUNT, static_cast<long long>(min_time.count() / 1000000));
+    for (size_t i = 0; i < results.size(); i++)
+    {
+        const BenchResult& r = results[i];
+        fprintf(file, "    {\"kernel\": \"%s\", \"variant\": \"%s\", \"y_align\": %d, \"unit\": \"%s\", "
+                      "\"ns_per_op\": %.3f, \"iterations\": %llu, \"bytes_per_frame\": ",
+                r.kernel.c_str(), r.variant.c_str(), r.y_align, r.unit, r.ns_per_op,
+                static_cast<unsigned long long>(r.iterations));
+        if (r.bytes_per_frame < 0)
+        {
+            fprintf(file, "null}");
+        }
+        else
+        {
+            fprintf(file, "%ld}", r.bytes_per_frame);
+        }
+        fprintf(file, "%s\n", (i + 1 < results.size()) ? "," : "");
+    }
+    fprintf(file, "  ]\n}\n");
+}
+
+int main(int argc, char** argv)
+{
+    const char* out = nullptr;
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--quick") == 0)
+        {
+            min_time = std::chrono::milliseconds(1);
+            repeats = 2;
+        }
+        else if (strcmp(argv[i], "--out") == 0 && i + 1 < argc)
+        {
+            out = argv[++i];
+        }
+        else
+        {
+            fprintf(stderr, "usage: lcd-bench [--quick] [--out results.json]\n");
+            return 2;
+        }
+    }
+
+    for_each_font([](const char* name, const auto& font)
+    {
+        bench_blit(name, font);
+        bench_print_buffer(name, font);
+        bench_print(name, font);
+    });
+    bench_put_char_xy();
+    bench_rects();
+    bench_refresh_screen();
+
+    FILE* file = (out != nullptr) ? fopen(out, "w") : stdout;
+    if (file == nullptr)
+    {
+        fprintf(stderr, "cannot write %s\n", out);
+        return 1;
+    }
+    write_json(file);
+    if (out != nullptr && fclose(file) != 0)
+    {
+        fprintf(stderr, "cannot write %s\n", out);
+        return 1;
+    }
+    return 0;
+}
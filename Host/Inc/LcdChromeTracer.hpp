@@ -0,0 +1,200 @@
+
+/**
+ * @file LcdChromeTracer.hpp
+ * @brief This file contains the timeline recorder of the host build.
+ *
+ * LcdChromeTracer collects the trace events of a driver built with LCD_ENABLE_TRACE=1 and writes
+ * them in the Chrome trace event format (JSON), which chrome://tracing and ui.perfetto.dev open
+ * as a timeline. Public calls show up as nested slices with their flushes and transport bursts
+ * inside; background frames show up as async slices.
+ *
+ * @author Ömer Gökyer
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <chrono>
+#include <vector>
+
+#include "lcd_host_hal.h"
+#include "LcdTrace.hpp"
+
+/**
+ * @brief Records the trace events of LcdDriver and exports them as a Chrome trace.
+ *
+ * @usage
+ * LcdChromeTracer tracer;
+ * tracer.attach();
+ * print_examples(lcd, 1);
+ * tracer.detach();
+ * tracer.save_json("session.json");
+ */
+class LcdChromeTracer : public LcdTraceSink {
+
+    public:
+
+        /**
+         * @brief Time base of the timestamps.
+         */
+        enum class Clock : uint8_t {
+
+            Virtual,    /**< The virtual clock of the HAL stand-in: bus time of the cost model. */
+            Wall        /**< The steady clock of the host: time spent in the driver code. */
+        };
+
+        /**
+         * @brief One recorded event.
+         */
+        struct Event {
+
+            LcdTracePhase phase;
+            const char* name;
+            const char* category;
+            uint32_t bytes;
+            uint64_t time_ns;
+        };
+
+        explicit LcdChromeTracer(Clock time_base = Clock::Virtual) : clock(time_base) {}
+
+        ~LcdChromeTracer(){
+
+            detach();
+        }
+
+        LcdChromeTracer(const LcdChromeTracer&) = delete;
+        LcdChromeTracer& operator=(const LcdChromeTracer&) = delete;
+
+        /**
+         * @brief Makes this tracer the receiver of the driver events.
+         */
+        void attach(){
+
+            lcd_trace_sink = this;
+        }
+
+        /**
+         * @brief Stops receiving events, if this tracer is attached.
+         */
+        void detach(){
+
+            if (lcd_trace_sink == this){
+
+                lcd_trace_sink = nullptr;
+            }
+        }
+
+        void trace(LcdTracePhase phase, const char* name, const char* category, uint32_t bytes) override {
+
+            log.push_back(Event{phase, name, category, bytes, now()});
+        }
+
+        /**
+         * @brief Returns the recorded events, oldest first.
+         */
+        const std::vector<Event>& events() const {
+
+            return log;
+        }
+
+        /**
+         * @brief Counts the Begin events of one name, for example the flushes of a session.
+         */
+        size_t count(const char* name) const {
+
+            size_t total = 0;
+            for (const Event& event : log){
+
+                if ((event.phase == LcdTracePhase::Begin || event.phase == LcdTracePhase::AsyncBegin) &&
+                    strcmp(event.name, name) == 0){
+
+                    total++;
+                }
+            }
+            return total;
+        }
+
+        /**
+         * @brief Forgets every recorded event.
+         */
+        void clear(){
+
+            log.clear();
+        }
+
+        /**
+         * @brief Writes the events as a Chrome trace JSON object.
+         *
+         * Timestamps are in microseconds with nanosecond decimals. Async frames get consecutive
+         * ids, so a frame chained behind another one gets a slice of its own.
+         *
+         * @param file The open file to write to.
+         * @return True if everything was written.
+         */
+        bool write_json(FILE* file) const {
+
+            bool ok = fprintf(file, "{\"displayTimeUnit\": \"ns\", \"traceEvents\": [\n") >= 0;
+            uint32_t async_begun = 0;
+            uint32_t async_ended = 0;
+            for (size_t i = 0; i < log.size(); i++){
+
+                const Event& event = log[i];
+                static const char phases[] = {'B', 'E', 'b', 'e'};
+                char phase = phases[static_cast<uint8_t>(event.phase)];
+                ok = ok && fprintf(file, "  {\"name\": \"%s\", \"cat\": \"%s\", \"ph\": \"%c\", \"ts\": %llu.%03u, "
+                                         "\"pid\": 1, \"tid\": 1",
+                                   event.name, event.category, phase,
+                                   static_cast<unsigned long long>(event.time_ns / 1000),
+                                   static_cast<unsigned>(event.time_ns % 1000)) >= 0;
+                if (event.phase == LcdTracePhase::AsyncBegin){
+
+                    ok = ok && fprintf(file, ", \"id\": %u", ++async_begun) >= 0;
+                }
+                else if (event.phase == LcdTracePhase::AsyncEnd){
+
+                    ok = ok && fprintf(file, ", \"id\": %u", ++async_ended) >= 0;
+                }
+                if (event.bytes != 0 && event.phase != LcdTracePhase::End && event.phase != LcdTracePhase::AsyncEnd){
+
+                    ok = ok && fprintf(file, ", \"args\": {\"bytes\": %u}", static_cast<unsigned>(event.bytes)) >= 0;
+                }
+                ok = ok && fprintf(file, "}%s\n", (i + 1 < log.size()) ? "," : "") >= 0;
+            }
+            return ok && fprintf(file, "]}\n") >= 0;
+        }
+
+        /**
+         * @brief Saves the events as a Chrome trace JSON file.
+         *
+         * @param path The file to create.
+         * @return True if the file was written.
+         */
+        bool save_json(const char* path) const {
+
+            FILE* file = fopen(path, "w");
+            if (file == nullptr){
+
+                return false;
+            }
+            bool ok = write_json(file);
+            return fclose(file) == 0 && ok;
+        }
+
+    private:
+
+        uint64_t now() const {
+
+            if (clock == Clock::Virtual){
+
+                return lcd_host_time_ns();
+            }
+            std::chrono::nanoseconds elapsed = std::chrono::steady_clock::now() - wall_start;
+            return static_cast<uint64_t>(elapsed.count());
+        }
+
+        Clock clock;
+        std::chrono::steady_clock::time_point wall_start{std::chrono::steady_clock::now()};
+        std::vector<Event> log;
+};
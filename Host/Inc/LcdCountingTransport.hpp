@@ -0,0 +1,85 @@
+
+/**
+ * @file LcdCountingTransport.hpp
+ * @brief This file contains a transport of the host build that only counts the traffic.
+ *
+ * @author Ömer Gökyer
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#include "LcdTransport.hpp"
+
+/**
+ * @brief Transport that drops the bytes and counts them.
+ *
+ * Stands in for the bus when only the work of the driver is of interest, as in the benchmarks:
+ * a send costs a few additions, so the time measured is the time of the rendering code. The
+ * counters tell how many bytes each frame would have put on the real bus.
+ *
+ * @usage
+ * LcdCountingTransport bus;
+ * LcdDriver lcd(bus);
+ * lcd.refresh_screen();
+ * uint32_t bytes = bus.data_bytes + bus.command_bytes;
+ */
+class LcdCountingTransport : public LcdTransport {
+
+    public:
+
+        void set_line(LcdLine line, bool level) override {
+
+            if (line == LcdLine::DC){
+
+                data_mode = level;
+            }
+            else if (line == LcdLine::CE && level != ce_level){
+
+                ce_level = level;
+                ce_transitions++;
+                if (!level){
+
+                    transactions++;
+                }
+            }
+        }
+
+        void send(const uint8_t* data, uint16_t length) override {
+
+            (data_mode ? data_bytes : command_bytes) += length;
+            sends++;
+        }
+
+        /**
+         * @brief Sets every counter back to 0.
+         */
+        void reset(){
+
+            command_bytes = 0;
+            data_bytes = 0;
+            sends = 0;
+            transactions = 0;
+            ce_transitions = 0;
+        }
+
+        /**
+         * @brief Returns the command and data bytes counted since the last reset().
+         */
+        uint32_t total_bytes() const {
+
+            return command_bytes + data_bytes;
+        }
+
+        uint32_t command_bytes{0};      /**< Bytes sent with DC low. */
+        uint32_t data_bytes{0};         /**< Bytes sent with DC high. */
+        uint32_t sends{0};              /**< Calls of send(). */
+        uint32_t transactions{0};       /**< Falling edges of CE. */
+        uint32_t ce_transitions{0};     /**< Level changes of CE, both edges. */
+
+    private:
+
+        bool data_mode{false};
+        bool ce_level{true};
+};
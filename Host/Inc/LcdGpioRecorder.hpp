@@ -0,0 +1,84 @@
+
+/**
+ * @file LcdGpioRecorder.hpp
+ * @brief This file contains the recording GPIO backend of the host build.
+ *
+ * @author Ömer Gökyer
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+
+#include "lcd_host_hal.h"
+
+/**
+ * @brief Keeps a log of every GPIO port change of the host build.
+ *
+ * @usage
+ * LcdGpioRecorder recorder;
+ * lcd_host_attach(&recorder);
+ * lcd.init();
+ * size_t bits = recorder.rising_edges(1, GPIO_PIN_11);   // CLK on PB11
+ */
+class LcdGpioRecorder : public LcdHostGpioSink {
+
+    public:
+
+        /**
+         * @brief One write to a GPIO port.
+         */
+        struct Event {
+
+            uint8_t port;           /**< Index of the port (0 for GPIOA). */
+            uint16_t previous;      /**< Output register before the write. */
+            uint16_t current;       /**< Output register after the write. */
+        };
+
+        void gpio_changed(uint8_t port, uint16_t previous, uint16_t current) override {
+
+            log.push_back(Event{port, previous, current});
+        }
+
+        /**
+         * @brief Returns the recorded writes, oldest first.
+         */
+        const std::vector<Event>& events() const {
+
+            return log;
+        }
+
+        /**
+         * @brief Counts the low to high transitions of one pin.
+         *
+         * @param port Index of the port (0 for GPIOA).
+         * @param pin The pin mask, for example GPIO_PIN_11.
+         * @return The number of rising edges.
+         */
+        size_t rising_edges(uint8_t port, uint16_t pin) const {
+
+            size_t count = 0;
+            for (const Event& event : log){
+
+                if (event.port == port && (event.previous & pin) == 0 && (event.current & pin) != 0){
+
+                    count++;
+                }
+            }
+            return count;
+        }
+
+        /**
+         * @brief Forgets every recorded write.
+         */
+        void clear(){
+
+            log.clear();
+        }
+
+    private:
+
+        std::vector<Event> log;
+};
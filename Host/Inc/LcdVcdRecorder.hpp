@@ -0,0 +1,254 @@
+
+/**
+ * @file LcdVcdRecorder.hpp
+ * @brief This file contains the waveform recording GPIO backend of the host build.
+ *
+ * LcdVcdRecorder timestamps every transition of a set of named pins with the virtual clock of the
+ * HAL stand-in and writes them as a Value Change Dump (IEEE 1364 VCD) file, which GTKWave and
+ * most logic analyzer tools open directly. The timing follows the LcdHostCostModel, so changing
+ * the model shows how the bus timing moves with the cost of a GPIO write.
+ *
+ * @author Ömer Gökyer
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <vector>
+
+#include "lcd_host_hal.h"
+
+/**
+ * @brief Records the transitions of named GPIO pins and exports them as a VCD file.
+ *
+ * @usage
+ * LcdVcdRecorder vcd;
+ * vcd.add_signal("RST", {1, GPIO_PIN_14});
+ * vcd.add_signal("CE", {1, GPIO_PIN_13});
+ * lcd_host_attach(&vcd);
+ * lcd.init();
+ * vcd.save_vcd("init.vcd");
+ */
+class LcdVcdRecorder : public LcdHostGpioSink {
+
+    public:
+
+        /**
+         * @brief One transition of a recorded signal.
+         */
+        struct Change {
+
+            uint64_t time_ns;       /**< Virtual time of the transition. */
+            uint8_t signal;         /**< Index of the signal, in the order of add_signal(). */
+            bool level;             /**< Level after the transition. */
+        };
+
+        /** Number of signals a recording can hold: one per printable VCD identifier code. */
+        static const uint8_t MAX_SIGNALS{94};
+
+        /** Returned by add_signal() when the recording already holds MAX_SIGNALS signals. */
+        static const uint8_t NO_SIGNAL{0xFF};
+
+        /**
+         * @brief Adds a pin to the recording. Up to MAX_SIGNALS signals can be recorded.
+         *
+         * @param name The name shown in the waveform viewer.
+         * @param pin The pin to watch.
+         * @return The index of the signal, or NO_SIGNAL if the recording is full.
+         */
+        uint8_t add_signal(const char* name, LcdHostPin pin){
+
+            if (signals.size() == MAX_SIGNALS){
+
+                return NO_SIGNAL;
+            }
+            signals.push_back(Signal{name, pin, level(pin)});
+            return static_cast<uint8_t>(signals.size() - 1);
+        }
+
+        void gpio_changed(uint8_t port, uint16_t previous, uint16_t current) override {
+
+            uint16_t changed = previous ^ current;
+            for (size_t i = 0; i < signals.size(); i++){
+
+                const LcdHostPin& pin = signals[i].pin;
+                if (pin.port == port && (changed & pin.mask) != 0){
+
+                    log.push_back(Change{lcd_host_time_ns(), static_cast<uint8_t>(i), (current & pin.mask) != 0});
+                }
+            }
+        }
+
+        /**
+         * @brief Starts a new recording window at the current virtual time.
+         *
+         * Forgets the recorded transitions and takes the current pin levels as the initial values.
+         */
+        void clear(){
+
+            log.clear();
+            start_ns = lcd_host_time_ns();
+            for (Signal& signal : signals){
+
+                signal.initial = level(signal.pin);
+            }
+        }
+
+        /**
+         * @brief Returns the recorded transitions, oldest first.
+         */
+        const std::vector<Change>& changes() const {
+
+            return log;
+        }
+
+        /**
+         * @brief Counts the transitions of one signal in the recording window.
+         *
+         * @param signal The index returned by add_signal().
+         * @return The number of rising and falling edges.
+         */
+        size_t toggles(uint8_t signal) const {
+
+            size_t count = 0;
+            for (const Change& change : log){
+
+                if (change.signal == signal){
+
+                    count++;
+                }
+            }
+            return count;
+        }
+
+        /**
+         * @brief Measures how long a signal was low between the start of the window and now.
+         *
+         * On the CE line this is the bus occupancy of the recorded frames.
+         *
+         * @param signal The index returned by add_signal().
+         * @return The low time in nanoseconds, 0 for NO_SIGNAL.
+         */
+        uint64_t low_time_ns(uint8_t signal) const {
+
+            if (signal >= signals.size()){
+
+                return 0;
+            }
+            uint64_t total = 0;
+            uint64_t since = start_ns;
+            bool high = signals[signal].initial;
+            for (const Change& change : log){
+
+                if (change.signal != signal){
+
+                    continue;
+                }
+                if (!high){
+
+                    total += change.time_ns - since;
+                }
+                high = change.level;
+                since = change.time_ns;
+            }
+            if (!high){
+
+                total += lcd_host_time_ns() - since;
+            }
+            return total;
+        }
+
+        /**
+         * @brief Returns the virtual time at which the recording window started.
+         */
+        uint64_t start_time_ns() const {
+
+            return start_ns;
+        }
+
+        /**
+         * @brief Writes the recording window as a VCD file with a 1 ns timescale.
+         *
+         * Times are relative to the start of the window. The file ends with a timestamp at the
+         * current virtual time, so the viewer shows the idle tail after the last transition.
+         *
+         * @param file The open file to write to.
+         * @return True if everything was written.
+         */
+        bool write_vcd(FILE* file) const {
+
+            bool ok = fprintf(file, "$version lcd-host LcdVcdRecorder $end\n$timescale 1ns $end\n"
+                                    "$scope module lcd $end\n") >= 0;
+            for (size_t i = 0; i < signals.size(); i++){
+
+                ok = ok && fprintf(file, "$var wire 1 %c %s $end\n", code(i), signals[i].name) >= 0;
+            }
+            ok = ok && fprintf(file, "$upscope $end\n$enddefinitions $end\n#0\n$dumpvars\n") >= 0;
+            for (size_t i = 0; i < signals.size(); i++){
+
+                ok = ok && fprintf(file, "%d%c\n", signals[i].initial ? 1 : 0, code(i)) >= 0;
+            }
+            ok = ok && fprintf(file, "$end\n") >= 0;
+
+            uint64_t stamp = 0;
+            for (const Change& change : log){
+
+                uint64_t time = change.time_ns - start_ns;
+                if (time != stamp){
+
+                    ok = ok && fprintf(file, "#%llu\n", static_cast<unsigned long long>(time)) >= 0;
+                    stamp = time;
+                }
+                ok = ok && fprintf(file, "%d%c\n", change.level ? 1 : 0, code(change.signal)) >= 0;
+            }
+            uint64_t end = lcd_host_time_ns() - start_ns;
+            if (end != stamp){
+
+                ok = ok && fprintf(file, "#%llu\n", static_cast<unsigned long long>(end)) >= 0;
+            }
+            return ok;
+        }
+
+        /**
+         * @brief Saves the recording window as a VCD file.
+         *
+         * @param path The file to create.
+         * @return True if the file was written.
+         */
+        bool save_vcd(const char* path) const {
+
+            FILE* file = fopen(path, "w");
+            if (file == nullptr){
+
+                return false;
+            }
+            bool ok = write_vcd(file);
+            return fclose(file) == 0 && ok;
+        }
+
+    private:
+
+        struct Signal {
+
+            const char* name;
+            LcdHostPin pin;
+            bool initial;
+        };
+
+        static bool level(LcdHostPin pin){
+
+            return (lcd_host_gpio[pin.port].ODR & pin.mask) != 0;
+        }
+
+        /* VCD identifier codes are printable ASCII characters from '!' to '~'. */
+        static char code(size_t signal){
+
+            return static_cast<char>('!' + signal);
+        }
+
+        std::vector<Signal> signals;
+        std::vector<Change> log;
+        uint64_t start_ns{lcd_host_time_ns()};
+};
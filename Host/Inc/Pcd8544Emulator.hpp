@@ -0,0 +1,390 @@
+
+/**
+ * @file Pcd8544Emulator.hpp
+ * @brief This file contains a software model of the PCD8544 controller for the host build.
+ *
+ * Pcd8544Emulator keeps the 6 x 84 byte display RAM and the controller state, and executes the
+ * command and data bytes the driver sends: function set (PD, V, H), display control, set X and
+ * set Y address in the basic instruction set, and temperature control, bias and Vop in the
+ * extended instruction set. Data bytes auto-increment the address in horizontal or vertical
+ * addressing and wrap around at the end of the RAM, like the real controller.
+ *
+ * Bytes can reach the model in two ways:
+ * - Pcd8544SerialDecoder listens to the host GPIO ports and decodes the RST, CE, DC, CLK and DIN
+ *   pins, so it checks the pin level behaviour of any GPIO based transport.
+ * - LcdEmulatorTransport is a transport that hands the bytes to the model directly.
+ *
+ * The panel contents can be saved as PBM images.
+ *
+ * @author Ömer Gökyer
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "lcd_host_hal.h"
+#include "LcdTransport.hpp"
+
+/**
+ * @brief Software model of the PCD8544 84x48 LCD controller.
+ */
+class Pcd8544Emulator {
+
+    public:
+
+        static const uint8_t WIDTH{84};
+        static const uint8_t HEIGHT{48};
+        static const uint8_t BANKS{HEIGHT / 8};
+        static const uint16_t SIZE{WIDTH * BANKS};
+
+        Pcd8544Emulator(){
+
+            reset();
+        }
+
+        /**
+         * @brief Applies the RST pulse: the state after reset, with the RAM left untouched.
+         *
+         * As on the real controller the chip is powered down, the basic instruction set and
+         * horizontal addressing are selected and the display is blank.
+         */
+        void reset(){
+
+            power_down = true;
+            vertical = false;
+            extended = false;
+            display_mode = 0;
+            x = 0;
+            y = 0;
+            vop = 0;
+            bias = 0;
+            temperature = 0;
+        }
+
+        /**
+         * @brief Executes one byte.
+         *
+         * @param byte The byte clocked in.
+         * @param data True if DC was high (display data), false for a command.
+         */
+        void write(uint8_t byte, bool data){
+
+            if (data){
+
+                ram[y * WIDTH + x] = byte;
+                data_bytes++;
+                advance();
+                return;
+            }
+            command_bytes++;
+            if ((byte & 0xF8) == 0x20){
+
+                power_down = (byte & 0x04) != 0;
+                vertical = (byte & 0x02) != 0;
+                extended = (byte & 0x01) != 0;
+            }
+            else if (extended){
+
+                if (byte & 0x80){
+
+                    vop = byte & 0x7F;
+                }
+                else if ((byte & 0xF8) == 0x10){
+
+                    bias = byte & 0x07;
+                }
+                else if ((byte & 0xFC) == 0x04){
+
+                    temperature = byte & 0x03;
+                }
+            }
+            else {
+
+                if (byte & 0x80){
+
+                    if ((byte & 0x7F) < WIDTH){
+
+                        x = byte & 0x7F;
+                    }
+                }
+                else if ((byte & 0xF8) == 0x40){
+
+                    if ((byte & 0x07) < BANKS){
+
+                        y = byte & 0x07;
+                    }
+                }
+                else if ((byte & 0xFA) == 0x08){
+
+                    display_mode = static_cast<uint8_t>(((byte >> 1) & 0x02) | (byte & 0x01));
+                }
+            }
+        }
+
+        /**
+         * @brief Tells whether a pixel is dark on the panel.
+         *
+         * Takes the display mode into account: blank, all segments on, normal or inverse video.
+         *
+         * @param px The x coordinate, 0 to 83.
+         * @param py The y coordinate, 0 to 47.
+         * @return True if the pixel is dark.
+         */
+        bool pixel(uint8_t px, uint8_t py) const {
+
+            if (power_down){
+
+                return false;
+            }
+            bool bit = (ram[(py / 8) * WIDTH + px] >> (py % 8)) & 0x01;
+            switch (display_mode){
+
+                case 0: return false;           // display blank
+                case 1: return true;            // all display segments on
+                case 2: return bit;             // normal mode
+                default: return !bit;           // inverse video mode
+            }
+        }
+
+        /**
+         * @brief Returns the display RAM in buffer order (bank * 84 + x).
+         */
+        const uint8_t* ddram() const {
+
+            return ram;
+        }
+
+        /**
+         * @brief Tells whether two panels show the same pixels.
+         *
+         * @param other The panel to compare with.
+         * @return True if every pixel matches.
+         */
+        bool same_pixels(const Pcd8544Emulator& other) const {
+
+            for (uint8_t py = 0; py < HEIGHT; py++){
+
+                for (uint8_t px = 0; px < WIDTH; px++){
+
+                    if (pixel(px, py) != other.pixel(px, py)){
+
+                        return false;
+                    }
+                }
+            }
+            return true;
+        }
+
+        /**
+         * @brief Writes the panel as a binary PBM (P4) image, dark pixels as 1.
+         *
+         * @param file The open file to write to.
+         * @return True if everything was written.
+         */
+        bool write_pbm(FILE* file) const {
+
+            if (fprintf(file, "P4\n%d %d\n", WIDTH, HEIGHT) < 0){
+
+                return false;
+            }
+            for (uint8_t py = 0; py < HEIGHT; py++){
+
+                uint8_t row[(WIDTH + 7) / 8]{};
+                for (uint8_t px = 0; px < WIDTH; px++){
+
+                    if (pixel(px, py)){
+
+                        row[px / 8] = static_cast<uint8_t>(row[px / 8] | (0x80 >> (px % 8)));
+                    }
+                }
+                if (fwrite(row, 1, sizeof(row), file) != sizeof(row)){
+
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        /**
+         * @brief Saves the panel as a binary PBM (P4) image.
+         *
+         * @param path The file to create.
+         * @return True if the file was written.
+         */
+        bool save_pbm(const char* path) const {
+
+            FILE* file = fopen(path, "wb");
+            if (file == nullptr){
+
+                return false;
+            }
+            bool ok = write_pbm(file);
+            return fclose(file) == 0 && ok;
+        }
+
+        bool power_down;
+        bool vertical;
+        bool extended;
+        uint8_t display_mode;   /**< D and E bits of display control: 0 blank, 1 all on, 2 normal, 3 inverse. */
+        uint8_t x;
+        uint8_t y;
+        uint8_t vop;
+        uint8_t bias;
+        uint8_t temperature;
+        uint32_t command_bytes{0};
+        uint32_t data_bytes{0};
+
+    private:
+
+        /**
+         * @brief Moves the address to the next cell after a data byte.
+         */
+        void advance(){
+
+            if (vertical){
+
+                if (++y == BANKS){
+
+                    y = 0;
+                    if (++x == WIDTH){
+
+                        x = 0;
+                    }
+                }
+                return;
+            }
+            if (++x == WIDTH){
+
+                x = 0;
+                if (++y == BANKS){
+
+                    y = 0;
+                }
+            }
+        }
+
+        uint8_t ram[SIZE]{};
+};
+
+/**
+ * @brief Decodes the serial interface of the PCD8544 from host GPIO pin changes.
+ *
+ * A byte is shifted in MSB first on the rising edges of CLK while CE is low. DC is sampled with
+ * the eighth bit. Raising CE drops an incomplete byte and a low RST resets the controller.
+ *
+ * @usage
+ * Pcd8544Emulator panel;
+ * Pcd8544SerialDecoder decoder(panel, {1, GPIO_PIN_14}, {1, GPIO_PIN_13}, {1, GPIO_PIN_12},
+ *                              {1, GPIO_PIN_10}, {1, GPIO_PIN_11});
+ * lcd_host_attach(&decoder);
+ */
+class Pcd8544SerialDecoder : public LcdHostGpioSink {
+
+    public:
+
+        using Pin = LcdHostPin;
+
+        Pcd8544SerialDecoder(Pcd8544Emulator& model, Pin rst_pin, Pin ce_pin, Pin dc_pin, Pin din_pin, Pin clk_pin)
+            : panel(model), rst(rst_pin), ce(ce_pin), dc(dc_pin), din(din_pin), clk(clk_pin) {}
+
+        void gpio_changed(uint8_t port, uint16_t previous, uint16_t current) override {
+
+            if (falls(rst, port, previous, current)){
+
+                panel.reset();
+                bits = 0;
+            }
+            if (rises(ce, port, previous, current) || falls(ce, port, previous, current)){
+
+                bits = 0;
+            }
+            if (rises(clk, port, previous, current) && !level(ce) && level(rst)){
+
+                shift = static_cast<uint8_t>((shift << 1) | (level(din) ? 1 : 0));
+                if (++bits == 8){
+
+                    panel.write(shift, level(dc));
+                    bits = 0;
+                }
+            }
+        }
+
+    private:
+
+        static bool level(Pin pin){
+
+            return (lcd_host_gpio[pin.port].ODR & pin.mask) != 0;
+        }
+
+        static bool rises(Pin pin, uint8_t port, uint16_t previous, uint16_t current){
+
+            return pin.port == port && (previous & pin.mask) == 0 && (current & pin.mask) != 0;
+        }
+
+        static bool falls(Pin pin, uint8_t port, uint16_t previous, uint16_t current){
+
+            return pin.port == port && (previous & pin.mask) != 0 && (current & pin.mask) == 0;
+        }
+
+        Pcd8544Emulator& panel;
+        Pin rst;
+        Pin ce;
+        Pin dc;
+        Pin din;
+        Pin clk;
+        uint8_t shift{0};
+        uint8_t bits{0};
+};
+
+/**
+ * @brief Transport that hands the byte stream straight to a Pcd8544Emulator.
+ *
+ * @usage
+ * Pcd8544Emulator panel;
+ * LcdEmulatorTransport bus(panel);
+ * LcdDriver lcd(bus);
+ */
+class LcdEmulatorTransport : public LcdTransport {
+
+    public:
+
+        explicit LcdEmulatorTransport(Pcd8544Emulator& model) : panel(model) {}
+
+        void set_line(LcdLine line, bool level) override {
+
+            switch (line){
+
+                case LcdLine::RST:
+
+                    if (!level){
+
+                        panel.reset();
+                    }
+                    break;
+                case LcdLine::CE:  selected = !level; break;
+                case LcdLine::DC:  data_mode = level; break;
+                default: break;
+            }
+        }
+
+        void send(const uint8_t* data, uint16_t length) override {
+
+            if (!selected){
+
+                return;
+            }
+            for (uint16_t n = 0; n < length; n++){
+
+                panel.write(data[n], data_mode);
+            }
+        }
+
+    private:
+
+        Pcd8544Emulator& panel;
+        bool selected{false};
+        bool data_mode{false};
+};
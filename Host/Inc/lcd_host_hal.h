@@ -0,0 +1,244 @@
+
+/**
+ * @file lcd_host_hal.h
+ * @brief This file contains the HAL stand-in used by the host build.
+ *
+ * It declares the subset of the STM32 HAL and CMSIS that the LCD driver uses: GPIO ports and
+ * pins, HAL_GPIO_WritePin(), HAL_Delay(), the DWT cycle counter and the interrupt mask intrinsics. GPIO ports are plain
+ * objects in RAM. Every write, through HAL_GPIO_WritePin() or through GPIOx->BSRR, updates the
+ * output register of the port and is reported to the attached LcdHostGpioSink objects, which
+ * record or decode the pin activity.
+ *
+ * The stand-in keeps a virtual clock in nanoseconds. GPIO writes, NOPs and HAL_Delay() advance it
+ * by the costs of the LcdHostCostModel, so sinks can timestamp pin changes as if the code ran on
+ * the target.
+ *
+ * @author Ömer Gökyer
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#define GPIO_PIN_0                 static_cast<uint16_t>(0x0001)
+#define GPIO_PIN_1                 static_cast<uint16_t>(0x0002)
+#define GPIO_PIN_2                 static_cast<uint16_t>(0x0004)
+#define GPIO_PIN_3                 static_cast<uint16_t>(0x0008)
+#define GPIO_PIN_4                 static_cast<uint16_t>(0x0010)
+#define GPIO_PIN_5                 static_cast<uint16_t>(0x0020)
+#define GPIO_PIN_6                 static_cast<uint16_t>(0x0040)
+#define GPIO_PIN_7                 static_cast<uint16_t>(0x0080)
+#define GPIO_PIN_8                 static_cast<uint16_t>(0x0100)
+#define GPIO_PIN_9                 static_cast<uint16_t>(0x0200)
+#define GPIO_PIN_10                static_cast<uint16_t>(0x0400)
+#define GPIO_PIN_11                static_cast<uint16_t>(0x0800)
+#define GPIO_PIN_12                static_cast<uint16_t>(0x1000)
+#define GPIO_PIN_13                static_cast<uint16_t>(0x2000)
+#define GPIO_PIN_14                static_cast<uint16_t>(0x4000)
+#define GPIO_PIN_15                static_cast<uint16_t>(0x8000)
+#define GPIO_PIN_All               static_cast<uint16_t>(0xFFFF)
+
+typedef enum
+{
+    GPIO_PIN_RESET = 0,
+    GPIO_PIN_SET
+} GPIO_PinState;
+
+/** Number of GPIO ports of the STM32F407 (GPIOA to GPIOI). */
+#define LCD_HOST_GPIO_PORTS 9
+
+/**
+ * @brief Write-only bit set/reset register of a host GPIO port.
+ *
+ * Assigning a value sets the pins of the lower half word and resets the pins of the upper half
+ * word, like the BSRR register of the STM32, in a single change of the port.
+ */
+struct LcdHostBsrr {
+
+    uint8_t port;
+
+    void operator=(uint32_t value);
+};
+
+/**
+ * @brief Host GPIO port: the output data register and its set/reset register.
+ */
+typedef struct
+{
+    uint16_t ODR;
+    LcdHostBsrr BSRR;
+} GPIO_TypeDef;
+
+extern GPIO_TypeDef lcd_host_gpio[LCD_HOST_GPIO_PORTS];
+
+#define GPIOA (&lcd_host_gpio[0])
+#define GPIOB (&lcd_host_gpio[1])
+#define GPIOC (&lcd_host_gpio[2])
+#define GPIOD (&lcd_host_gpio[3])
+#define GPIOE (&lcd_host_gpio[4])
+#define GPIOF (&lcd_host_gpio[5])
+#define GPIOG (&lcd_host_gpio[6])
+#define GPIOH (&lcd_host_gpio[7])
+#define GPIOI (&lcd_host_gpio[8])
+
+/**
+ * @brief A pin of a host GPIO port.
+ */
+struct LcdHostPin {
+
+    uint8_t port;       /**< Index of the port (0 for GPIOA). */
+    uint16_t mask;      /**< The pin mask, for example GPIO_PIN_11. */
+};
+
+/**
+ * @brief Time charged to the virtual clock for each operation, in nanoseconds.
+ *
+ * The defaults are rough figures for an STM32F407 at 168 MHz with the HAL built with -O2: a BSRR
+ * store takes two cycles, a HAL_GPIO_WritePin() call with its argument setup about twelve and a
+ * NOP one. Tune them to match a logic analyzer capture of the real board.
+ */
+struct LcdHostCostModel {
+
+    uint32_t hal_gpio_write_ns{72};     /**< One HAL_GPIO_WritePin() call. */
+    uint32_t bsrr_write_ns{12};         /**< One store to GPIOx->BSRR. */
+    uint32_t nop_ns{6};                 /**< One __NOP(). */
+};
+
+/**
+ * @brief Receives every change of a host GPIO port.
+ */
+class LcdHostGpioSink {
+
+    public:
+
+        /**
+         * @brief Called after a write to a GPIO port.
+         *
+         * Pins written in the same BSRR store change together, so the sink sees them in one call.
+         *
+         * @param port Index of the port (0 for GPIOA).
+         * @param previous The output register before the write.
+         * @param current The output register after the write.
+         */
+        virtual void gpio_changed(uint8_t port, uint16_t previous, uint16_t current) = 0;
+
+    protected:
+
+        ~LcdHostGpioSink() = default;
+};
+
+/**
+ * @brief Starts reporting GPIO writes to a sink. Up to 4 sinks can be attached.
+ */
+void lcd_host_attach(LcdHostGpioSink* sink);
+
+/**
+ * @brief Stops reporting GPIO writes to a sink.
+ */
+void lcd_host_detach(LcdHostGpioSink* sink);
+
+/**
+ * @brief Applies a BSRR style write to a host GPIO port and reports it to the sinks.
+ *
+ * @param port Index of the port (0 for GPIOA).
+ * @param bsrr Pins to set in the lower half word, pins to reset in the upper half word.
+ */
+void lcd_host_gpio_write(uint8_t port, uint32_t bsrr);
+
+/**
+ * @brief Resets every port to 0 and the virtual clock to 0. Attached sinks and the cost model
+ * stay as they are.
+ */
+void lcd_host_reset(void);
+
+/**
+ * @brief Replaces the cost model of the virtual clock.
+ */
+void lcd_host_set_cost_model(const LcdHostCostModel& model);
+
+/**
+ * @brief Returns the cost model of the virtual clock.
+ */
+const LcdHostCostModel& lcd_host_cost_model(void);
+
+/**
+ * @brief Returns the virtual time in nanoseconds since the last lcd_host_reset().
+ */
+uint64_t lcd_host_time_ns(void);
+
+/**
+ * @brief Advances the virtual clock.
+ */
+void lcd_host_advance_ns(uint64_t ns);
+
+#define SET_BIT(REG, BIT)          ((REG) |= (BIT))
+#define CLEAR_BIT(REG, BIT)        ((REG) &= ~(BIT))
+#define READ_BIT(REG, BIT)         ((REG) & (BIT))
+
+/** Core clock the DWT stand-in counts at, matching the defaults of LcdHostCostModel. */
+#define LCD_HOST_CORE_CLOCK_HZ     168000000U
+
+/**
+ * @brief Cycle counter register of the host DWT.
+ *
+ * Reads the virtual clock converted to core clock cycles, wrapping at 32 bits like CYCCNT. Writing
+ * a value restarts the count from it. The enable bits in DWT->CTRL and CoreDebug->DEMCR are
+ * stored but not modelled: the counter always runs.
+ */
+struct LcdHostCyccnt {
+
+    uint32_t offset;
+
+    operator uint32_t() const;
+    void operator=(uint32_t value);
+};
+
+typedef struct
+{
+    uint32_t CTRL;
+    LcdHostCyccnt CYCCNT;
+} DWT_Type;
+
+typedef struct
+{
+    uint32_t DEMCR;
+} CoreDebug_Type;
+
+extern DWT_Type lcd_host_dwt;
+extern CoreDebug_Type lcd_host_core_debug;
+
+#define DWT                         (&lcd_host_dwt)
+#define CoreDebug                   (&lcd_host_core_debug)
+#define DWT_CTRL_CYCCNTENA_Msk      (1U << 0)
+#define CoreDebug_DEMCR_TRCENA_Msk  (1U << 24)
+
+void HAL_GPIO_WritePin(GPIO_TypeDef* GPIOx, uint16_t GPIO_Pin, GPIO_PinState PinState);
+void HAL_Delay(uint32_t Delay);
+uint32_t HAL_GetTick(void);
+
+extern uint32_t lcd_host_primask;
+
+static inline void __NOP(void){
+
+    lcd_host_advance_ns(lcd_host_cost_model().nop_ns);
+}
+
+static inline uint32_t __get_PRIMASK(void){
+
+    return lcd_host_primask;
+}
+
+static inline void __set_PRIMASK(uint32_t priMask){
+
+    lcd_host_primask = priMask;
+}
+
+static inline void __disable_irq(void){
+
+    lcd_host_primask = 1;
+}
+
+static inline void __enable_irq(void){
+
+    lcd_host_primask = 0;
+}
@@ -0,0 +1,95 @@
+
+/**
+ * @file host_main.cpp
+ * @brief Host build of the example application.
+ *
+ * Runs the example screens of projectExamples.hpp against the HAL stand-in and reports the
+ * recorded pin activity. Exits with a non-zero status if the driver did not clock any data out.
+ *
+ * Usage: lcd-host-demo [output directory]
+ * With an output directory, the panel decoded by Pcd8544Emulator is saved as screen_<n>.pbm
+ * and the pin activity of the screen as screen_<n>.vcd after each screen. In a build with
+ * LCD_HOST_TRACE=ON, the driver activity of the whole session is also saved as session.json.
+ *
+ * @author Ömer Gökyer
+ */
+
+#include <stdio.h>
+
+#include "LcdChromeTracer.hpp"
+#include "LcdGpioRecorder.hpp"
+#include "LcdVcdRecorder.hpp"
+#include "Pcd8544Emulator.hpp"
+#include "projectExamples.hpp"
+
+int main(int argc, char** argv)
+{
+    const char* output_dir = (argc > 1) ? argv[1] : nullptr;
+    LcdGpioRecorder recorder;
+    lcd_host_attach(&recorder);
+    Pcd8544Emulator panel;
+    Pcd8544SerialDecoder decoder(panel, {1, GPIO_PIN_14}, {1, GPIO_PIN_13}, {1, GPIO_PIN_12}, {1, GPIO_PIN_10}, {1, GPIO_PIN_11});
+    lcd_host_attach(&decoder);
+    LcdVcdRecorder vcd;
+    vcd.add_signal("RST", {1, GPIO_PIN_14});
+    uint8_t ce = vcd.add_signal("CE", {1, GPIO_PIN_13});
+    vcd.add_signal("DC", {1, GPIO_PIN_12});
+    vcd.add_signal("DIN", {1, GPIO_PIN_10});
+    vcd.add_signal("CLK", {1, GPIO_PIN_11});
+    lcd_host_attach(&vcd);
+
+    LcdChromeTracer tracer;
+    tracer.attach();
+
+    LcdBus lcd_bus;
+    LcdDriver lcd(lcd_bus);
+    lcd.init();
+
+    const uint8_t port_b = 1;
+    size_t total_bits = 0;
+    for (int num = 0; num < 5; num++)
+    {
+        recorder.clear();
+        vcd.clear();
+        print_examples(lcd, num);
+        size_t bits = recorder.rising_edges(port_b, GPIO_PIN_11);
+        printf("screen %d: %zu GPIO writes, %zu bytes clocked out, bus busy %llu us\n", num, recorder.events().size(),
+               bits / 8, static_cast<unsigned long long>(vcd.low_time_ns(ce) / 1000));
+        total_bits += bits;
+        if (output_dir != nullptr)
+        {
+            char path[256];
+            snprintf(path, sizeof(path), "%s/screen_%d.pbm", output_dir, num);
+            if (!panel.save_pbm(path))
+            {
+                printf("cannot write %s\n", path);
+                return 1;
+            }
+            snprintf(path, sizeof(path), "%s/screen_%d.vcd", output_dir, num);
+            if (!vcd.save_vcd(path))
+            {
+                printf("cannot write %s\n", path);
+                return 1;
+            }
+        }
+    }
+
+#if LCD_ENABLE_TRACE
+    if (output_dir != nullptr)
+    {
+        char path[256];
+        snprintf(path, sizeof(path), "%s/session.json", output_dir);
+        if (!tracer.save_json(path))
+        {
+            printf("cannot write %s\n", path);
+            return 1;
+        }
+    }
+#endif
+
+    tracer.detach();
+    lcd_host_detach(&vcd);
+    lcd_host_detach(&decoder);
+    lcd_host_detach(&recorder);
+    return (total_bits > 0 && total_bits % 8 == 0) ? 0 : 1;
+}
@@ -0,0 +1,133 @@
+
+/**
+ * @file lcd_host_hal.cpp
+ * @brief This file contains the implementation of the host HAL stand-in.
+ *
+ * @author Ömer Gökyer
+ */
+
+#include "lcd_host_hal.h"
+
+GPIO_TypeDef lcd_host_gpio[LCD_HOST_GPIO_PORTS] = {
+    {0, {0}}, {0, {1}}, {0, {2}}, {0, {3}}, {0, {4}}, {0, {5}}, {0, {6}}, {0, {7}}, {0, {8}}
+};
+
+uint32_t lcd_host_primask = 0;
+DWT_Type lcd_host_dwt = {0, {0}};
+CoreDebug_Type lcd_host_core_debug = {0};
+
+static const uint8_t MAX_SINKS = 4;
+static LcdHostGpioSink* sinks[MAX_SINKS] = {nullptr};
+static uint64_t time_ns = 0;
+static LcdHostCostModel cost_model;
+
+static const uint64_t NS_PER_MS = 1000000;
+
+void LcdHostBsrr::operator=(uint32_t value){
+
+    time_ns += cost_model.bsrr_write_ns;
+    lcd_host_gpio_write(port, value);
+}
+
+/* Core clock cycles of the virtual clock. */
+static uint32_t cycles(void){
+
+    return static_cast<uint32_t>(time_ns * (LCD_HOST_CORE_CLOCK_HZ / 1000000) / 1000);
+}
+
+LcdHostCyccnt::operator uint32_t() const {
+
+    return cycles() - offset;
+}
+
+void LcdHostCyccnt::operator=(uint32_t value){
+
+    offset = cycles() - value;
+}
+
+void lcd_host_attach(LcdHostGpioSink* sink){
+
+    for (uint8_t i = 0; i < MAX_SINKS; i++){
+
+        if (sinks[i] == nullptr){
+
+            sinks[i] = sink;
+            return;
+        }
+    }
+}
+
+void lcd_host_detach(LcdHostGpioSink* sink){
+
+    for (uint8_t i = 0; i < MAX_SINKS; i++){
+
+        if (sinks[i] == sink){
+
+            sinks[i] = nullptr;
+        }
+    }
+}
+
+void lcd_host_gpio_write(uint8_t port, uint32_t bsrr){
+
+    GPIO_TypeDef& gpio = lcd_host_gpio[port];
+    uint16_t previous = gpio.ODR;
+    uint16_t set = static_cast<uint16_t>(bsrr & 0xFFFFU);
+    uint16_t reset = static_cast<uint16_t>(bsrr >> 16);
+    /* Like the hardware, set wins when a pin is both set and reset. */
+    gpio.ODR = static_cast<uint16_t>((previous & ~reset) | set);
+    for (uint8_t i = 0; i < MAX_SINKS; i++){
+
+        if (sinks[i] != nullptr){
+
+            sinks[i]->gpio_changed(port, previous, gpio.ODR);
+        }
+    }
+}
+
+void lcd_host_reset(void){
+
+    for (uint8_t i = 0; i < LCD_HOST_GPIO_PORTS; i++){
+
+        lcd_host_gpio[i].ODR = 0;
+    }
+    time_ns = 0;
+    lcd_host_primask = 0;
+}
+
+void lcd_host_set_cost_model(const LcdHostCostModel& model){
+
+    cost_model = model;
+}
+
+const LcdHostCostModel& lcd_host_cost_model(void){
+
+    return cost_model;
+}
+
+uint64_t lcd_host_time_ns(void){
+
+    return time_ns;
+}
+
+void lcd_host_advance_ns(uint64_t ns){
+
+    time_ns += ns;
+}
+
+void HAL_GPIO_WritePin(GPIO_TypeDef* GPIOx, uint16_t GPIO_Pin, GPIO_PinState PinState){
+
+    time_ns += cost_model.hal_gpio_write_ns;
+    uint32_t bsrr = (PinState == GPIO_PIN_SET) ? GPIO_Pin : static_cast<uint32_t>(GPIO_Pin) << 16;
+    lcd_host_gpio_write(GPIOx->BSRR.port, bsrr);
+}
+
+void HAL_Delay(uint32_t Delay){
+
+    time_ns += Delay * NS_PER_MS;
+}
+
+uint32_t HAL_GetTick(void){
+
+    return static_cast<uint32_t>(time_ns / NS_PER_MS);
+}
@@ -0,0 +1,428 @@
+
+/**
+ * @file emulator_test.cpp
+ * @brief Checks that every flush path leaves the panel pixel-identical to refresh_screen().
+ *
+ * A reference driver draws into its buffer only and sends the whole buffer with
+ * refresh_screen() to a Pcd8544Emulator. The drivers under test draw the same screens through
+ * their normal flush paths (planned partial flushes, frames, per-call flushes, the async flush)
+ * and their pin or byte stream is decoded into a second emulator. After each step both panels
+ * must show the same pixels.
+ *
+ * @author Ömer Gökyer
+ */
+
+#include "lcd_test.hpp"
+
+/* Example screens through LcdBsrrTransport, one planned partial flush per frame. */
+static void test_examples_bsrr()
+{
+    lcd_host_reset();
+    LcdTestPanel reference(LcdFlushPolicy::Manual);
+    Pcd8544Emulator panel;
+    Pcd8544SerialDecoder decoder(panel, {1, GPIO_PIN_14}, {1, GPIO_PIN_13}, {1, GPIO_PIN_12}, {1, GPIO_PIN_10}, {1, GPIO_PIN_11});
+    lcd_host_attach(&decoder);
+
+    LcdBus bus;
+    LcdDriver lcd(bus);
+    lcd.init();
+    CHECK(panel.same_pixels(reference.panel));
+
+    const int order[] = {0, 1, 2, 3, 4, 1, 0};
+    for (int num : order)
+    {
+        print_examples(lcd, num);
+        print_examples(reference.lcd, num);
+        reference.lcd.refresh_screen();
+        CHECK(panel.same_pixels(reference.panel));
+        CHECK(memcmp(panel.ddram(), reference.panel.ddram(), Pcd8544Emulator::SIZE) == 0);
+    }
+    CHECK(!panel.vertical && !panel.extended && panel.display_mode == 2);
+    lcd_host_detach(&decoder);
+}
+
+/* Per-call flushes through the HAL_GPIO_WritePin transport, pins spread over two ports. */
+static void test_per_call_gpio()
+{
+    lcd_host_reset();
+    LcdTestPanel reference(LcdFlushPolicy::Manual);
+    Pcd8544Emulator panel;
+    Pcd8544SerialDecoder decoder(panel, {2, GPIO_PIN_0}, {2, GPIO_PIN_1}, {2, GPIO_PIN_2}, {3, GPIO_PIN_5}, {3, GPIO_PIN_6});
+    lcd_host_attach(&decoder);
+
+    LcdDriver lcd;
+    lcd.set_pin(GPIOC, GPIO_PIN_0, LcdLine::RST);
+    lcd.set_pin(GPIOC, GPIO_PIN_1, LcdLine::CE);
+    lcd.set_pin(GPIOC, GPIO_PIN_2, LcdLine::DC);
+    lcd.set_pin(GPIOD, GPIO_PIN_5, LcdLine::DIN);
+    lcd.set_pin(GPIOD, GPIO_PIN_6, LcdLine::CLK);
+    lcd.init();
+
+    LcdDriver* drivers[] = {&lcd, &reference.lcd};
+    for (LcdDriver* d : drivers)
+    {
+        d->put_char_xy(menu_gui, 0, 0);
+        d->print_buffer("12:30", 3, 5, FontDefault);
+        d->invert(true);
+        d->print_buffer("Temp", 40, 29, Default);
+        d->invert(false);
+        d->print_buffer("7", 60, 10, FontWide);
+    }
+    reference.lcd.refresh_screen();
+    CHECK(panel.same_pixels(reference.panel));
+    lcd_host_detach(&decoder);
+}
+
+/* Tall, narrow changes take the vertical addressing path of the flush planner. */
+static void test_vertical_flush()
+{
+    LcdTestPanel reference(LcdFlushPolicy::Manual);
+    LcdTestPanel screen;
+
+    LcdDriver* drivers[] = {&screen.lcd, &reference.lcd};
+    for (LcdDriver* d : drivers)
+    {
+        d->draw_V_line(10, 0, 47);
+        d->draw_V_line(11, 2, 40);
+    }
+    uint32_t data = screen.panel.data_bytes;
+    screen.lcd.refresh_dirty();
+    reference.lcd.refresh_screen();
+    CHECK(screen.panel.same_pixels(reference.panel));
+    CHECK(!screen.panel.vertical);
+    CHECK(screen.panel.data_bytes - data == 12);   // both columns in one vertical run
+}
+
+/* A run continuing in the next bank is re-addressed with set X alone, and a gap that costs more
+   than that is no longer bridged. */
+static void test_single_command_readdress()
+{
+    LcdTestPanel reference(LcdFlushPolicy::Manual);
+    LcdTestPanel screen;
+    screen.lcd.set_flush_policy(LcdFlushPolicy::Manual);
+
+    LcdDriver* drivers[] = {&screen.lcd, &reference.lcd};
+    for (LcdDriver* d : drivers)
+    {
+        d->fill_rect(70, 0, 14, 8);         // bank 0 up to the last column
+        d->fill_rect(10, 8, 3, 8);          // the counter stands at (0, 1) after bank 0
+    }
+    uint32_t commands = screen.panel.command_bytes;
+    uint32_t data = screen.panel.data_bytes;
+    screen.lcd.refresh_dirty();
+    CHECK(screen.panel.command_bytes - commands == 2 + 1);
+    CHECK(screen.panel.data_bytes - data == 14 + 3);
+
+    for (LcdDriver* d : drivers)
+    {
+        d->fill_rect(60, 16, 24, 8);
+        d->fill_rect(2, 24, 4, 8);          // a 2 byte gap, 1 byte to re-address
+    }
+    commands = screen.panel.command_bytes;
+    data = screen.panel.data_bytes;
+    screen.lcd.refresh_dirty();
+    CHECK(screen.panel.command_bytes - commands == 2 + 1);
+    CHECK(screen.panel.data_bytes - data == 24 + 4);
+
+    reference.lcd.refresh_screen();
+    CHECK(screen.panel.same_pixels(reference.panel));
+}
+
+/* A full frame through refresh_screen_async(). */
+static void test_async_flush()
+{
+    LcdTestPanel reference(LcdFlushPolicy::Manual);
+    LcdTestPanel screen;
+
+    print_examples(screen.lcd, 2);
+    print_examples(reference.lcd, 2);
+    screen.lcd.print_buffer("async", 2, 40, FontTiny);
+    reference.lcd.print_buffer("async", 2, 40, FontTiny);
+    CHECK(screen.lcd.refresh_screen_async());
+    screen.lcd.wait_flush();
+    reference.lcd.refresh_screen();
+    CHECK(screen.panel.same_pixels(reference.panel));
+}
+
+/* An emulated bus whose asynchronous transfers fail before reaching the panel. */
+class LcdFailingTransport : public LcdEmulatorTransport {
+
+    public:
+
+        using LcdEmulatorTransport::LcdEmulatorTransport;
+
+        void send_async(const uint8_t* data, uint16_t length, LcdTransferCallback done, void* context) override
+        {
+            failed = fail;
+            if (!failed)
+            {
+                send(data, length);
+            }
+            done(context);
+        }
+
+        bool transfer_failed() const override
+        {
+            return failed;
+        }
+
+        bool fail{true};
+
+    private:
+
+        bool failed{false};
+};
+
+/* A failed async flush leaves the frame dirty, and the next flush sends it. */
+static void test_failed_async_flush()
+{
+    LcdTestPanel reference(LcdFlushPolicy::Manual);
+    Pcd8544Emulator panel;
+    LcdFailingTransport bus{panel};
+    LcdDriver lcd{bus};
+    lcd.set_flush_policy(LcdFlushPolicy::Manual);
+    lcd.init();
+    lcd.refresh_screen();
+
+    lcd.print_buffer("retry", 2, 16, FontTiny);
+    reference.lcd.print_buffer("retry", 2, 16, FontTiny);
+    reference.lcd.refresh_screen();
+    CHECK(lcd.refresh_screen_async());
+    lcd.wait_flush();
+    CHECK(lcd.is_dirty());
+    CHECK(!panel.same_pixels(reference.panel));
+
+    bus.fail = false;
+    lcd.refresh_dirty();
+    CHECK(!lcd.is_dirty());
+    CHECK(panel.same_pixels(reference.panel));
+}
+
+/* Glyphs land at their y at every bank alignment, and the font descriptors pick the right glyph. */
+static void test_glyph_placement()
+{
+    for (uint8_t y = 0; y < 16; y++)
+    {
+        LcdTestPanel screen;
+        screen.lcd.print_buffer("!", 0, y, FontDefault);
+        const uint8_t column = FontDefault.glyph('!')[2];
+        bool placed = true;
+        for (uint8_t row = 0; row < 8; row++)
+        {
+            placed = placed && (screen.panel.pixel(2, static_cast<uint8_t>(y + row)) == (((column >> row) & 1) != 0));
+        }
+        CHECK(placed);
+    }
+
+    /* FontMega starts at '.': '0' is its third glyph, drawn over four banks. */
+    LcdTestPanel screen;
+    screen.lcd.print("0", 0, 1, FontMega);
+    const uint32_t column = FontMegaData[2][1];
+    bool drawn = true;
+    for (uint8_t row = 0; row < 32; row++)
+    {
+        drawn = drawn && (screen.panel.pixel(1, static_cast<uint8_t>(8 + row)) == (((column >> row) & 1) != 0));
+    }
+    CHECK(drawn);
+    CHECK(!FontMega.contains(' ') && FontMega.glyph(' ')[1] == 0);
+
+    /* Tall fonts through the buffer match print() straight to the LCD, aligned or not. */
+    for (uint8_t y = 8; y < 13; y += 4)
+    {
+        LcdTestPanel direct(LcdFlushPolicy::Manual);
+        direct.lcd.print("0:5", 0, 1, FontHuge);
+        direct.lcd.print("AZ", 50, 1, FontLarge);
+        LcdTestPanel buffered;
+        buffered.lcd.print_buffer("0:5", 0, y, FontHuge);
+        buffered.lcd.print_buffer("AZ", 50, y, FontLarge);
+        bool same = true;
+        for (uint8_t py = 0; py < 32; py++)
+        {
+            for (uint8_t px = 0; px < 84; px++)
+            {
+                same = same && (direct.panel.pixel(px, static_cast<uint8_t>(8 + py)) ==
+                                buffered.panel.pixel(px, static_cast<uint8_t>(y + py)));
+            }
+        }
+        CHECK(same);
+    }
+}
+
+/* Bitmaps are drawn at any y and clipped at the right and bottom edges instead of wrapping. */
+static void test_bitmap_clipping()
+{
+    static const uint8_t block[] = {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x0F, 0x0F, 0x0F, 0x0F, 0x0F, 0x0F};
+    LcdTestPanel screen;
+    screen.lcd.draw_bitmap(80, 37, block, 6, 12);
+
+    size_t lit = 0;
+    for (uint8_t py = 0; py < 48; py++)
+    {
+        for (uint8_t px = 0; px < 84; px++)
+        {
+            lit += screen.panel.pixel(px, py) ? 1 : 0;
+        }
+    }
+    CHECK(lit == 4 * 11);           // columns 80..83, rows 37..47
+    const Pcd8544Emulator& panel = screen.panel;
+    CHECK(panel.pixel(80, 37) && panel.pixel(83, 47) && !panel.pixel(79, 37) && !panel.pixel(80, 36));
+}
+
+/* Every raster op changes exactly the pixels of the drawn rectangle, as its truth table says. */
+static void test_raster_ops()
+{
+    static uint8_t half[84 * 6];
+    for (uint16_t i = 0; i < sizeof(half); i++)
+    {
+        half[i] = (i % 84 < 42) ? 0xFF : 0x00;
+    }
+    static uint8_t checker[4 * 2];
+    for (uint8_t i = 0; i < 4; i++)
+    {
+        checker[i] = (i % 2 == 0) ? 0x55 : 0xAA;
+        checker[4 + i] = (i % 2 == 0) ? 0x01 : 0x02;
+    }
+    const LcdRasterOp ops[] = {LcdRasterOp::Copy, LcdRasterOp::Or, LcdRasterOp::And, LcdRasterOp::Xor, LcdRasterOp::Not,
+                                LcdRasterOp::Clear};
+
+    for (LcdRasterOp op : ops)
+    {
+        LcdTestPanel screen;
+        screen.lcd.draw_bitmap(0, 0, half, 84, 48);
+        screen.lcd.draw_bitmap(40, 5, checker, 4, 10, op);       // straddles the edge of the filled half
+
+        bool matches = true;
+        for (uint8_t py = 0; py < 48; py++)
+        {
+            for (uint8_t px = 0; px < 84; px++)
+            {
+                const bool d = px < 42;
+                bool expected = d;
+                if (px >= 40 && px < 44 && py >= 5 && py < 15)
+                {
+                    const bool s = (px + py) % 2 == 1;
+                    switch (op)
+                    {
+                        case LcdRasterOp::Copy: expected = s; break;
+                        case LcdRasterOp::Or:   expected = d || s; break;
+                        case LcdRasterOp::And:  expected = d && s; break;
+                        case LcdRasterOp::Xor:  expected = d != s; break;
+                        case LcdRasterOp::Not:  expected = !s; break;
+                        case LcdRasterOp::Clear: expected = d && !s; break;
+                    }
+                }
+                matches = matches && screen.panel.pixel(px, py) == expected;
+            }
+        }
+        CHECK(matches);
+    }
+
+    /* Xor toggles: the second cursor and the second label undo the first. */
+    LcdTestPanel screen;
+    screen.lcd.draw_bitmap(0, 0, half, 84, 48);
+    Pcd8544Emulator before = screen.panel;
+    screen.lcd.draw_bitmap(40, 5, checker, 4, 10, LcdRasterOp::Xor);
+    screen.lcd.print_buffer("Sel", 30, 19, FontDefault, LcdRasterOp::Xor);
+    CHECK(!screen.panel.same_pixels(before));
+    screen.lcd.print_buffer("Sel", 30, 19, FontDefault, LcdRasterOp::Xor);
+    screen.lcd.draw_bitmap(40, 5, checker, 4, 10, LcdRasterOp::Xor);
+    CHECK(screen.panel.same_pixels(before));
+
+    screen.lcd.set_raster_op(LcdRasterOp::Xor);
+    CHECK(screen.lcd.raster_op() == LcdRasterOp::Xor);
+    screen.lcd.invert(true);
+    CHECK(screen.lcd.raster_op() == LcdRasterOp::Clear);
+    screen.lcd.invert(false);
+    CHECK(screen.lcd.raster_op() == LcdRasterOp::Or);
+}
+
+/* Rectangles and lines change exactly their clipped pixels at every alignment. */
+static void test_rects()
+{
+    const int rects[][4] = {{5, 3, 40, 16}, {0, 8, 84, 8}, {30, 2, 3, 4}, {-4, 40, 12, 20}, {80, -3, 10, 6}};
+    for (const int* r : rects)
+    {
+        for (int shift = 0; shift < 8; shift++)
+        {
+            const int x = r[0], y = r[1] + shift, w = r[2], h = r[3];
+            LcdTestPanel screen;
+            screen.lcd.fill_rect(0, 0, 42, 48);
+            screen.lcd.fill_rect(x, y, w, h, LcdRasterOp::Xor);
+            screen.lcd.refresh_screen();
+
+            bool matches = true;
+            for (int py = 0; py < 48; py++)
+            {
+                for (int px = 0; px < 84; px++)
+                {
+                    const bool inside = px >= x && px < x + w && py >= y && py < y + h;
+                    matches = matches && screen.panel.pixel(static_cast<uint8_t>(px), static_cast<uint8_t>(py)) == ((px < 42) != inside);
+                }
+            }
+            CHECK(matches);
+
+            screen.lcd.invert_rect(x, y, w, h);
+            screen.lcd.clear_rect(0, 0, 21, 48);
+            screen.lcd.refresh_screen();
+            size_t lit = 0;
+            for (uint8_t py = 0; py < 48; py++)
+            {
+                for (uint8_t px = 0; px < 84; px++)
+                {
+                    lit += screen.panel.pixel(px, py) ? 1 : 0;
+                }
+            }
+            CHECK(lit == 21 * 48);          // the inverted rectangle is restored, columns 21..41 are left
+        }
+    }
+
+    LcdTestPanel screen;
+    screen.lcd.draw_H_line(70, 13, 30);     // clipped at the right edge
+    screen.lcd.draw_V_line(5, 40, 20);      // clipped at the bottom edge
+    screen.lcd.refresh_screen();
+    const Pcd8544Emulator& panel = screen.panel;
+    CHECK(panel.pixel(70, 13) && panel.pixel(83, 13) && !panel.pixel(69, 13) && !panel.pixel(70, 14) && !panel.pixel(0, 14));
+    CHECK(panel.pixel(5, 40) && panel.pixel(5, 47) && !panel.pixel(5, 39) && !panel.pixel(6, 40));
+
+    screen.lcd.invert_rect(60, 30, 4, 4);   // PerCall: the toggle shows without a refresh
+    CHECK(panel.pixel(60, 30) && panel.pixel(63, 33));
+    screen.lcd.invert_rect(60, 30, 4, 4);
+    CHECK(!panel.pixel(60, 30) && !panel.pixel(63, 33));
+}
+
+/* The model itself: wrap-around and display modes. */
+static void test_emulator_model()
+{
+    Pcd8544Emulator panel;
+    panel.write(0x20, false);
+    panel.write(0x0C, false);
+    panel.write(0x80 | 83, false);
+    panel.write(0x40 | 5, false);
+    panel.write(0x01, true);
+    panel.write(0x80, true);
+    CHECK(panel.x == 1 && panel.y == 0);
+    CHECK(panel.pixel(83, 40) && panel.pixel(0, 7));
+    panel.write(0x0D, false);
+    CHECK(!panel.pixel(83, 40) && panel.pixel(1, 0));
+    panel.write(0x22, false);
+    panel.write(0x80 | 83, false);
+    panel.write(0x40 | 5, false);
+    panel.write(0xFF, true);
+    CHECK(panel.x == 0 && panel.y == 0);
+}
+
+int main()
+{
+    test_emulator_model();
+    test_examples_bsrr();
+    test_per_call_gpio();
+    test_vertical_flush();
+    test_single_command_readdress();
+    test_async_flush();
+    test_failed_async_flush();
+    test_glyph_placement();
+    test_bitmap_clipping();
+    test_raster_ops();
+    test_rects();
+    return lcd_test_result("emulator_test");
+}
@@ -0,0 +1,114 @@
+
+/**
+ * @file glyph_cache_test.cpp
+ * @brief Checks the pre-shifted glyph cache of LcdDriver.
+ *
+ * Built with LCD_GLYPH_CACHE_SIZE=8. Text drawn through the cache must leave the panel
+ * pixel-identical to the same glyphs drawn with draw_bitmap(), which never uses the cache.
+ *
+ * @author Ömer Gökyer
+ */
+
+#include <string.h>
+
+#include "lcd_test.hpp"
+
+static_assert(LCD_GLYPH_CACHE_SIZE == 8, "glyph_cache_test must be built with LCD_GLYPH_CACHE_SIZE=8");
+
+/* Draws the glyphs of a string one by one with draw_bitmap(). */
+template <typename Font>
+static void draw_uncached(LcdDriver& lcd, const char* str, uint8_t x, uint8_t y, const Font& font)
+{
+    for (; *str; str++, x = static_cast<uint8_t>(x + Font::width))
+    {
+        lcd.draw_bitmap(x, y, font.glyph_bytes(*str), Font::width, Font::height);
+    }
+}
+
+/* Every alignment, plain and inverted, matches the uncached drawing; repeats are hits. */
+static void test_pixel_identity()
+{
+    static uint8_t filled[84 * 6];
+    memset(filled, 0xFF, sizeof(filled));
+    for (uint8_t y = 0; y < 16; y++)
+    {
+        for (bool inverted : {false, true})
+        {
+            LcdTestPanel cached;
+            LcdTestPanel reference;
+            if (inverted)
+            {
+                cached.lcd.draw_bitmap(0, 0, filled, 84, 48);
+                reference.lcd.draw_bitmap(0, 0, filled, 84, 48);
+            }
+            cached.lcd.invert(inverted);
+            reference.lcd.invert(inverted);
+            cached.lcd.print_buffer("Menu", 80, y, FontDefault);     // clipped at the right edge
+            cached.lcd.print_buffer("1:Menu", 0, y, FontDefault);
+            cached.lcd.print_buffer("AB", 40, y, FontLarge);
+            draw_uncached(reference.lcd, "Menu", 80, y, FontDefault);
+            draw_uncached(reference.lcd, "1:Menu", 0, y, FontDefault);
+            draw_uncached(reference.lcd, "AB", 40, y, FontLarge);
+            cached.lcd.refresh_screen();
+            reference.lcd.refresh_screen();
+            CHECK(cached.panel.same_pixels(reference.panel));
+
+            const LcdGlyphCacheStats& stats = cached.lcd.glyph_cache_stats();
+            if (y % 8 == 0)
+            {
+                CHECK(stats.hits == 0 && stats.misses == 0);    // aligned glyphs need no shifting
+            }
+            else
+            {
+                CHECK(stats.misses == 8 && stats.hits == 1);    // only the M of the clipped "Menu" is drawn
+            }
+        }
+    }
+}
+
+/* The least recently used glyph is evicted first; oversized glyphs bypass the cache. */
+static void test_eviction()
+{
+    LcdTestPanel panel;
+    panel.lcd.set_flush_policy(LcdFlushPolicy::Manual);
+    panel.lcd.print_buffer("ABCDEFGH", 0, 3, FontDefault);
+    CHECK(panel.lcd.glyph_cache_stats().misses == 8);
+    panel.lcd.print_buffer("A", 0, 3, FontDefault);       // A becomes the most recent
+    panel.lcd.print_buffer("I", 0, 3, FontDefault);       // evicts B
+    panel.lcd.print_buffer("A", 0, 3, FontDefault);
+    CHECK(panel.lcd.glyph_cache_stats().hits == 2 && panel.lcd.glyph_cache_stats().misses == 9);
+    panel.lcd.print_buffer("B", 0, 3, FontDefault);
+    CHECK(panel.lcd.glyph_cache_stats().misses == 10);
+    panel.lcd.print_buffer("A", 0, 4, FontDefault);       // another shift is another entry
+    CHECK(panel.lcd.glyph_cache_stats().misses == 11);
+
+    panel.lcd.print_buffer("0", 0, 3, FontMega);
+    CHECK(panel.lcd.glyph_cache_stats().misses == 11 && panel.lcd.glyph_cache_stats().hits == 2);
+
+    panel.lcd.clear_glyph_cache();
+    CHECK(panel.lcd.glyph_cache_stats().hits == 0 && panel.lcd.glyph_cache_stats().misses == 0);
+    panel.lcd.print_buffer("A", 0, 3, FontDefault);
+    CHECK(panel.lcd.glyph_cache_stats().misses == 1);
+}
+
+/* A status line redrawn every frame is all hits after the first frame. */
+static void test_steady_state()
+{
+    LcdTestPanel panel;
+    for (int frame = 0; frame < 10; frame++)
+    {
+        LcdDriver::Frame guard(panel.lcd);
+        panel.lcd.clear_area(0, 36, 84, 8);
+        panel.lcd.print_buffer("T:21C", 0, 37, FontTiny);
+    }
+    CHECK(panel.lcd.glyph_cache_stats().misses == 5);
+    CHECK(panel.lcd.glyph_cache_stats().hits == 9 * 5);
+}
+
+int main()
+{
+    test_pixel_identity();
+    test_eviction();
+    test_steady_state();
+    return lcd_test_result("glyph_cache_test");
+}
@@ -0,0 +1,65 @@
+/**
+ * @file lcd_test.hpp
+ * @brief This file contains the check macro and the emulated panel fixture of the host tests.
+ *
+ * @author Ömer Gökyer
+ */
+
+#pragma once
+
+#include <stdio.h>
+
+#include "Pcd8544Emulator.hpp"
+#include "projectExamples.hpp"
+
+/** Number of failed checks of the test program. */
+inline int lcd_test_failures = 0;
+
+/** Reports a failed check with its file and line; the test program goes on. */
+#define CHECK(condition) lcd_test_check((condition), #condition, __FILE__, __LINE__)
+
+inline void lcd_test_check(bool condition, const char* text, const char* file, int line)
+{
+    if (!condition)
+    {
+        printf("%s:%d: check failed: %s\n", file, line, text);
+        lcd_test_failures++;
+    }
+}
+
+/**
+ * @brief Prints the summary of a test program and returns its exit code.
+ *
+ * @param name Name of the test program.
+ * @return 0 if every check passed, 1 otherwise.
+ */
+inline int lcd_test_result(const char* name)
+{
+    if (lcd_test_failures == 0)
+    {
+        printf("%s: all checks passed\n", name);
+    }
+    return lcd_test_failures == 0 ? 0 : 1;
+}
+
+/**
+ * @brief A driver on an emulated panel, initialized.
+ */
+struct LcdTestPanel {
+
+    Pcd8544Emulator panel;
+    LcdEmulatorTransport bus{panel};
+    LcdDriver lcd{bus};
+
+    LcdTestPanel()
+    {
+        lcd.init();
+    }
+
+    /* Selects the flush policy before init(). */
+    explicit LcdTestPanel(LcdFlushPolicy policy)
+    {
+        lcd.set_flush_policy(policy);
+        lcd.init();
+    }
+};
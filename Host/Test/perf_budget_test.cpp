@@ -0,0 +1,199 @@
+
+/**
+ * @file perf_budget_test.cpp
+ * @brief Fails when a standard scenario sends more than its checked-in budget.
+ *
+ * Every scenario runs twice: on LcdCountingTransport, which counts the bytes sent, the command
+ * bytes and the CE transitions, and on the BSRR transport of the examples, where
+ * LcdGpioRecorder counts the GPIO writes. The counters are deterministic, so the budgets do not
+ * depend on the speed of the machine running the tests.
+ *
+ * Usage: lcd-perf-budget-test <budget file>
+ *        lcd-perf-budget-test --write <budget file>
+ *
+ * The budget file has one line per scenario: the name, then the budgets of bytes, command bytes,
+ * CE transitions and GPIO writes per frame. Lines starting with # are comments. --write replaces
+ * the file with the current counts, for use after an intended change of the byte stream.
+ *
+ * @author Ömer Gökyer
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+#include "LcdCountingTransport.hpp"
+#include "LcdGpioRecorder.hpp"
+#include "projectExamples.hpp"
+
+/**
+ * @brief Counters of one frame.
+ */
+struct FrameCost {
+
+    std::string scenario;
+    unsigned long bytes;
+    unsigned long command_bytes;
+    unsigned long ce_transitions;
+    unsigned long gpio_writes;
+};
+
+/**
+ * @brief Runs the scenarios on the counting transport and the GPIO transport side by side.
+ */
+class ScenarioRunner {
+
+    public:
+
+        ScenarioRunner() : counted(counting), wired(bsrr) {
+
+            lcd_host_reset();
+            lcd_host_attach(&recorder);
+            counted.init();
+            wired.init();
+        }
+
+        ~ScenarioRunner(){
+
+            lcd_host_detach(&recorder);
+        }
+
+        /**
+         * @brief Runs one scenario on both drivers and records its counters.
+         */
+        template <typename Draw>
+        void run(const char* scenario, Draw&& draw){
+
+            counting.reset();
+            recorder.clear();
+            draw(counted);
+            draw(wired);
+            costs.push_back(FrameCost{scenario, counting.total_bytes(), counting.command_bytes,
+                                      counting.ce_transitions, recorder.events().size()});
+        }
+
+        std::vector<FrameCost> costs;
+
+    private:
+
+        LcdCountingTransport counting;
+        LcdBus bsrr;
+        LcdGpioRecorder recorder;
+        LcdDriver counted;
+        LcdDriver wired;
+};
+
+static std::vector<FrameCost> measure()
+{
+    ScenarioRunner runner;
+    const char* screens[] = {"example_0", "example_1", "example_2", "example_3", "example_4"};
+    for (int num = 0; num < 5; num++)
+    {
+        runner.run(screens[num], [num](LcdDriver& lcd) { print_examples(lcd, num); });
+    }
+    runner.run("clear", [](LcdDriver& lcd) { lcd.clear(); });
+    runner.run("label", [](LcdDriver& lcd) { lcd.print_buffer("42", 60, 0, FontDefault); });
+    return runner.costs;
+}
+
+static bool read_budgets(const char* path, std::vector<FrameCost>& budgets)
+{
+    FILE* file = fopen(path, "r");
+    if (file == nullptr)
+    {
+        printf("cannot read %s\n", path);
+        return false;
+    }
+    char line[256];
+    while (fgets(line, sizeof(line), file) != nullptr)
+    {
+        char name[64];
+        FrameCost budget{};
+        if (line[0] == '#' ||
+            sscanf(line, "%63s %lu %lu %lu %lu", name, &budget.bytes, &budget.command_bytes,
+                   &budget.ce_transitions, &budget.gpio_writes) != 5)
+        {
+            continue;
+        }
+        budget.scenario = name;
+        budgets.push_back(budget);
+    }
+    fclose(file);
+    return true;
+}
+
+static bool write_budgets(const char* path, const std::vector<FrameCost>& costs)
+{
+    FILE* file = fopen(path, "w");
+    if (file == nullptr)
+    {
+        printf("cannot write %s\n", path);
+        return false;
+    }
+    fprintf(file, "# Per frame budgets of perf_budget_test.cpp. Regenerate with\n"
+                  "# lcd-perf-budget-test --write <this file> after an intended change.\n"
+                  "# scenario    bytes  command_bytes  ce_transitions  gpio_writes\n");
+    for (const FrameCost& cost : costs)
+    {
+        fprintf(file, "%-12s %6lu %14lu %15lu %12lu\n", cost.scenario.c_str(), cost.bytes,
+                cost.command_bytes, cost.ce_transitions, cost.gpio_writes);
+    }
+    return fclose(file) == 0;
+}
+
+static int check(const char* metric, const FrameCost& cost, unsigned long measured, unsigned long budget)
+{
+    if (measured > budget)
+    {
+        printf("%s: %s %lu over budget %lu\n", cost.scenario.c_str(), metric, measured, budget);
+        return 1;
+    }
+    return 0;
+}
+
+int main(int argc, char** argv)
+{
+    if (argc == 3 && strcmp(argv[1], "--write") == 0)
+    {
+        return write_budgets(argv[2], measure()) ? 0 : 1;
+    }
+    if (argc != 2)
+    {
+        printf("usage: lcd-perf-budget-test [--write] <budget file>\n");
+        return 2;
+    }
+
+    std::vector<FrameCost> budgets;
+    if (!read_budgets(argv[1], budgets))
+    {
+        return 1;
+    }
+
+    int failures = 0;
+    for (const FrameCost& cost : measure())
+    {
+        const FrameCost* budget = nullptr;
+        for (const FrameCost& b : budgets)
+        {
+            if (b.scenario == cost.scenario)
+            {
+                budget = &b;
+            }
+        }
+        if (budget == nullptr)
+        {
+            printf("%s: no budget in %s\n", cost.scenario.c_str(), argv[1]);
+            failures++;
+            continue;
+        }
+        printf("%-12s bytes %lu/%lu  command bytes %lu/%lu  CE %lu/%lu  GPIO writes %lu/%lu\n",
+               cost.scenario.c_str(), cost.bytes, budget->bytes, cost.command_bytes, budget->command_bytes,
+               cost.ce_transitions, budget->ce_transitions, cost.gpio_writes, budget->gpio_writes);
+        failures += check("bytes", cost, cost.bytes, budget->bytes);
+        failures += check("command bytes", cost, cost.command_bytes, budget->command_bytes);
+        failures += check("CE transitions", cost, cost.ce_transitions, budget->ce_transitions);
+        failures += check("GPIO writes", cost, cost.gpio_writes, budget->gpio_writes);
+    }
+    return failures == 0 ? 0 : 1;
+}
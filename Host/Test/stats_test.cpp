@@ -0,0 +1,88 @@
+
+/**
+ * @file stats_test.cpp
+ * @brief Checks the counters and profiling zones of LcdDriver::stats().
+ *
+ * Built with LCD_ENABLE_STATS=1. The byte counters are compared with what Pcd8544Emulator
+ * decodes from the pins. The zones read the host DWT stand-in, which follows the virtual clock:
+ * only GPIO writes and NOPs take time there, so the flush zone has cycles while the render and
+ * clear zones, which only touch the buffer, count runs.
+ *
+ * @author Ömer Gökyer
+ */
+
+#include "lcd_test.hpp"
+
+static_assert(LCD_ENABLE_STATS, "stats_test must be built with LCD_ENABLE_STATS=1");
+
+/* The host DWT counts the virtual clock in core clock cycles. */
+static void test_cycle_counter()
+{
+    lcd_host_reset();
+    DWT->CYCCNT = 100;
+    HAL_Delay(1);
+    CHECK(DWT->CYCCNT == 100 + LCD_HOST_CORE_CLOCK_HZ / 1000);
+}
+
+/* Byte counters match the decoded stream and every flush is timed. */
+static void test_counters()
+{
+    lcd_host_reset();
+    Pcd8544Emulator panel;
+    Pcd8544SerialDecoder decoder(panel, {1, GPIO_PIN_14}, {1, GPIO_PIN_13}, {1, GPIO_PIN_12}, {1, GPIO_PIN_10}, {1, GPIO_PIN_11});
+    lcd_host_attach(&decoder);
+
+    LcdBus bus;
+    LcdDriver lcd(bus);
+    lcd.init();
+    CHECK(CoreDebug->DEMCR & CoreDebug_DEMCR_TRCENA_Msk);
+    CHECK(lcd.stats().frames_flushed == 1);           // the clear() of init()
+    CHECK(lcd.stats().commands_sent == panel.command_bytes);
+
+    for (int num = 0; num < 5; num++)
+    {
+        print_examples(lcd, num);
+    }
+    lcd.print_buffer("42", 60, 0, FontDefault);
+    lcd.clear_area(60, 0, 12, 8);
+    lcd.refresh_dirty();
+
+    const LcdStats& stats = lcd.stats();
+    CHECK(stats.bytes_sent == panel.data_bytes);
+    CHECK(stats.commands_sent == panel.command_bytes);
+    CHECK(stats.frames_flushed == 1 + 5 + 2);
+    CHECK(stats.flush.count == stats.frames_flushed);
+    CHECK(stats.flush.worst_cycles > 0);
+    CHECK(stats.flush.worst_cycles >= stats.flush.average_cycles());
+    CHECK(stats.flush.average_cycles() >= stats.flush.last_cycles);   // the last flush is a small one
+    CHECK(stats.render.count == 1 + 19 + 19 + 21 + 18 + 2);   // characters of the screens and the label
+    CHECK(stats.clear.count == 1 + 5 + 1);                    // clear() calls and the clear_area()
+
+    lcd.reset_stats();
+    CHECK(lcd.stats().frames_flushed == 0 && lcd.stats().flush.worst_cycles == 0);
+    lcd_host_detach(&decoder);
+}
+
+/* A background flush counts as a frame when it completes. */
+static void test_async_frame()
+{
+    lcd_host_reset();
+    LcdTestPanel screen;
+    screen.lcd.set_flush_policy(LcdFlushPolicy::Manual);
+    screen.lcd.reset_stats();
+
+    screen.lcd.print_buffer("async", 2, 40, FontTiny);
+    CHECK(screen.lcd.refresh_screen_async());
+    screen.lcd.wait_flush();
+    CHECK(screen.lcd.stats().frames_flushed == 1);
+    CHECK(screen.lcd.stats().bytes_sent == 504);
+    CHECK(screen.lcd.stats().flush.count == 0);
+}
+
+int main()
+{
+    test_cycle_counter();
+    test_counters();
+    test_async_frame();
+    return lcd_test_result("stats_test");
+}
@@ -0,0 +1,179 @@
+
+/**
+ * @file trace_test.cpp
+ * @brief Checks the trace hooks of LcdDriver and the Chrome trace export.
+ *
+ * Built with LCD_ENABLE_TRACE=1.
+ *
+ * @author Ömer Gökyer
+ */
+
+#include <string.h>
+#include <vector>
+
+#include "LcdChromeTracer.hpp"
+#include "lcd_test.hpp"
+
+static_assert(LCD_ENABLE_TRACE, "trace_test must be built with LCD_ENABLE_TRACE=1");
+
+/* Every End closes the most recent open Begin of the same name, and nothing stays open. */
+static bool well_nested(const LcdChromeTracer& tracer)
+{
+    std::vector<const char*> open;
+    for (const LcdChromeTracer::Event& event : tracer.events())
+    {
+        if (event.phase == LcdTracePhase::Begin)
+        {
+            open.push_back(event.name);
+        }
+        else if (event.phase == LcdTracePhase::End)
+        {
+            if (open.empty() || strcmp(open.back(), event.name) != 0)
+            {
+                return false;
+            }
+            open.pop_back();
+        }
+    }
+    return open.empty();
+}
+
+/* Sums the bytes of the transport bursts. */
+static uint32_t burst_bytes(const LcdChromeTracer& tracer, const char* name)
+{
+    uint32_t total = 0;
+    for (const LcdChromeTracer::Event& event : tracer.events())
+    {
+        if (event.phase == LcdTracePhase::Begin && strcmp(event.name, name) == 0)
+        {
+            total += event.bytes;
+        }
+    }
+    return total;
+}
+
+/* A frame of the examples: one planned flush, bursts inside the calls, bytes as decoded. */
+static void test_frame_session()
+{
+    lcd_host_reset();
+    Pcd8544Emulator panel;
+    Pcd8544SerialDecoder decoder(panel, {1, GPIO_PIN_14}, {1, GPIO_PIN_13}, {1, GPIO_PIN_12}, {1, GPIO_PIN_10}, {1, GPIO_PIN_11});
+    lcd_host_attach(&decoder);
+
+    LcdBus bus;
+    LcdDriver lcd(bus);
+    LcdChromeTracer tracer;
+    tracer.attach();
+    lcd.init();
+    print_examples(lcd, 1);
+    tracer.detach();
+    lcd_host_detach(&decoder);
+
+    CHECK(well_nested(tracer));
+    CHECK(tracer.count("init") == 1);
+    CHECK(tracer.count("begin_frame") == 1 && tracer.count("end_frame") == 1);
+    CHECK(tracer.count("clear") == 2);
+    CHECK(tracer.count("full_frame") == 1);         // the clear() of init()
+    CHECK(tracer.count("planned") + tracer.count("planned_vertical") == 1);
+    CHECK(tracer.count("print_buffer") == 3 && tracer.count("put_char_xy") == 2);
+    CHECK(burst_bytes(tracer, "data") == panel.data_bytes);
+    CHECK(burst_bytes(tracer, "command") == panel.command_bytes);
+
+    /* Bus time lands inside the slices: the first event is at the start of init(). */
+    const std::vector<LcdChromeTracer::Event>& events = tracer.events();
+    CHECK(!events.empty() && strcmp(events.front().name, "init") == 0);
+    CHECK(!events.empty() && events.back().time_ns > events.front().time_ns);
+}
+
+/* With the PerCall policy, each print_buffer() flushes exactly once. */
+static void test_flushes_per_call()
+{
+    LcdTestPanel screen;
+
+    LcdChromeTracer tracer(LcdChromeTracer::Clock::Wall);
+    tracer.attach();
+    screen.lcd.print_buffer("12:30", 3, 5, FontDefault);
+    screen.lcd.print_buffer("Temp", 40, 29, Default);
+    tracer.detach();
+    CHECK(well_nested(tracer));
+    CHECK(tracer.count("print_buffer") == 2);
+    CHECK(tracer.count("planned") + tracer.count("planned_vertical") == 2);
+    CHECK(tracer.count("full_frame") == 0);
+}
+
+/* set_pixel() and the transaction calls are traced like the other public calls. */
+static void test_pixel_and_transaction()
+{
+    LcdTestPanel screen;
+
+    LcdChromeTracer tracer;
+    tracer.attach();
+    screen.lcd.set_pixel(10, 20, true);
+    screen.lcd.begin_transaction();
+    screen.lcd.end_transaction();
+    tracer.detach();
+    CHECK(well_nested(tracer));
+    CHECK(tracer.count("set_pixel") == 1);
+    CHECK(tracer.count("begin_transaction") == 1 && tracer.count("end_transaction") == 1);
+}
+
+/* A background frame is an async slice. */
+static void test_async_frame()
+{
+    LcdTestPanel screen;
+
+    LcdChromeTracer tracer;
+    tracer.attach();
+    CHECK(screen.lcd.refresh_screen_async());
+    screen.lcd.wait_flush();
+    tracer.detach();
+    CHECK(tracer.count("async_frame") == 1);
+    size_t ends = 0;
+    for (const LcdChromeTracer::Event& event : tracer.events())
+    {
+        ends += (event.phase == LcdTracePhase::AsyncEnd) ? 1 : 0;
+    }
+    CHECK(ends == 1);
+}
+
+/* The JSON has one line per event and the phase letters of the format. */
+static void test_json()
+{
+    LcdChromeTracer tracer;
+    tracer.attach();
+    LcdTestPanel screen;                    // init() is traced too
+    CHECK(screen.lcd.refresh_screen_async());
+    tracer.detach();
+
+    FILE* file = tmpfile();
+    CHECK(file != nullptr);
+    if (file == nullptr)
+    {
+        return;
+    }
+    CHECK(tracer.write_json(file));
+    rewind(file);
+
+    char line[256];
+    size_t lines = 0, begins = 0, async_begins = 0;
+    while (fgets(line, sizeof(line), file) != nullptr)
+    {
+        lines++;
+        begins += (strstr(line, "\"ph\": \"B\"") != nullptr) ? 1 : 0;
+        async_begins += (strstr(line, "\"ph\": \"b\", ") != nullptr && strstr(line, "\"id\": 1") != nullptr) ? 1 : 0;
+    }
+    fclose(file);
+    CHECK(lines == tracer.events().size() + 2);
+    CHECK(begins * 2 + 2 == tracer.events().size());
+    CHECK(async_begins == 1);
+}
+
+int main()
+{
+    test_frame_session();
+    test_flushes_per_call();
+    test_pixel_and_transaction();
+    test_async_frame();
+    test_json();
+    return lcd_test_result("trace_test");
+}
@@ -0,0 +1,228 @@
+
+/**
+ * @file vcd_test.cpp
+ * @brief Checks the virtual clock of the HAL stand-in and the VCD waveform export.
+ *
+ * @author Ömer Gökyer
+ */
+
+#include <stdint.h>
+#include <string.h>
+
+#include "LcdVcdRecorder.hpp"
+#include "lcd_test.hpp"
+
+/**
+ * @brief The five LCD lines of LcdBus as recorded signals.
+ */
+struct BusSignals {
+
+    uint8_t rst, ce, dc, din, clk;
+
+    explicit BusSignals(LcdVcdRecorder& vcd)
+        : rst(vcd.add_signal("RST", {1, GPIO_PIN_14})),
+          ce(vcd.add_signal("CE", {1, GPIO_PIN_13})),
+          dc(vcd.add_signal("DC", {1, GPIO_PIN_12})),
+          din(vcd.add_signal("DIN", {1, GPIO_PIN_10})),
+          clk(vcd.add_signal("CLK", {1, GPIO_PIN_11})) {}
+};
+
+/* Draws example screen 1 on a fresh display and returns the CE low time of that frame. */
+static uint64_t frame_occupancy(LcdVcdRecorder& vcd, const BusSignals& bus)
+{
+    lcd_host_reset();
+    LcdBus lcd_bus;
+    LcdDriver lcd(lcd_bus);
+    lcd.init();
+    vcd.clear();
+    print_examples(lcd, 1);
+    return vcd.low_time_ns(bus.ce);
+}
+
+/* Shortest time between two CLK edges of the recording. */
+static uint64_t min_clk_half_period_ns(const LcdVcdRecorder& vcd, const BusSignals& bus)
+{
+    uint64_t shortest = UINT64_MAX;
+    uint64_t last = 0;
+    bool seen = false;
+    for (const LcdVcdRecorder::Change& change : vcd.changes())
+    {
+        if (change.signal != bus.clk)
+        {
+            continue;
+        }
+        if (seen && change.time_ns - last < shortest)
+        {
+            shortest = change.time_ns - last;
+        }
+        last = change.time_ns;
+        seen = true;
+    }
+    return shortest;
+}
+
+/* Costs of the model show up on the virtual clock. */
+static void test_virtual_clock()
+{
+    lcd_host_reset();
+    const LcdHostCostModel& model = lcd_host_cost_model();
+    uint64_t start = lcd_host_time_ns();
+    HAL_GPIO_WritePin(GPIOA, GPIO_PIN_0, GPIO_PIN_SET);
+    CHECK(lcd_host_time_ns() - start == model.hal_gpio_write_ns);
+    GPIOA->BSRR = GPIO_PIN_1;
+    __NOP();
+    CHECK(lcd_host_time_ns() - start == model.hal_gpio_write_ns + model.bsrr_write_ns + model.nop_ns);
+    HAL_Delay(5);
+    CHECK(HAL_GetTick() == 5);
+    lcd_host_reset();
+    CHECK(lcd_host_time_ns() == 0 && HAL_GetTick() == 0);
+}
+
+/* Toggle counts and bus occupancy of one frame. */
+static void test_frame_waveform()
+{
+    LcdVcdRecorder vcd;
+    BusSignals bus(vcd);
+    lcd_host_attach(&vcd);
+    uint64_t occupancy = frame_occupancy(vcd, bus);
+    lcd_host_detach(&vcd);
+
+    size_t clk = vcd.toggles(bus.clk);
+    CHECK(clk > 0 && clk % 16 == 0);                        // a full byte is two edges per bit
+    CHECK(vcd.toggles(bus.ce) % 2 == 0);                    // every transaction deselects again
+    CHECK(vcd.toggles(bus.rst) == 0);
+    CHECK(occupancy > 0 && occupancy <= lcd_host_time_ns() - vcd.start_time_ns());
+
+    uint64_t last = 0;
+    bool ordered = true;
+    for (const LcdVcdRecorder::Change& change : vcd.changes())
+    {
+        ordered = ordered && change.time_ns >= last;
+        last = change.time_ns;
+    }
+    CHECK(ordered);
+
+    /* The PCD8544 clocks at most 4 MHz: CLK stays low and high for at least 125 ns each. */
+    CHECK(min_clk_half_period_ns(vcd, bus) >= 125);
+}
+
+/* The half periods are paced by the cycle counter: a slower NOP overshoots each one by at most
+   one NOP and the toggles stay the same. */
+static void test_cost_model()
+{
+    LcdVcdRecorder vcd;
+    BusSignals bus(vcd);
+    lcd_host_attach(&vcd);
+    uint64_t fast = frame_occupancy(vcd, bus);
+    size_t fast_clk = vcd.toggles(bus.clk);
+
+    LcdHostCostModel slow;
+    slow.nop_ns = 2 * slow.nop_ns;
+    lcd_host_set_cost_model(slow);
+    uint64_t slower = frame_occupancy(vcd, bus);
+    lcd_host_set_cost_model(LcdHostCostModel{});
+    lcd_host_detach(&vcd);
+
+    CHECK(vcd.toggles(bus.clk) == fast_clk);
+    CHECK(slower >= fast);
+    CHECK(slower - fast <= fast_clk * slow.nop_ns);
+}
+
+/* The same screen through the per-call HAL transport clocks the same number of bits. */
+static void test_transport_toggles()
+{
+    LcdVcdRecorder vcd;
+    BusSignals bus(vcd);
+    lcd_host_attach(&vcd);
+    frame_occupancy(vcd, bus);
+    size_t bsrr_clk = vcd.toggles(bus.clk);
+    size_t bsrr_ce = vcd.toggles(bus.ce);
+
+    lcd_host_reset();
+    LcdDriver lcd;
+    lcd.set_pin(GPIOB, GPIO_PIN_14, LcdLine::RST);
+    lcd.set_pin(GPIOB, GPIO_PIN_13, LcdLine::CE);
+    lcd.set_pin(GPIOB, GPIO_PIN_12, LcdLine::DC);
+    lcd.set_pin(GPIOB, GPIO_PIN_10, LcdLine::DIN);
+    lcd.set_pin(GPIOB, GPIO_PIN_11, LcdLine::CLK);
+    lcd.init();
+    vcd.clear();
+    print_examples(lcd, 1);
+    lcd_host_detach(&vcd);
+
+    CHECK(vcd.toggles(bus.clk) == bsrr_clk);
+    CHECK(vcd.toggles(bus.ce) == bsrr_ce);
+}
+
+/* The file has the VCD header, one initial value per signal and one line per change. */
+static void test_vcd_file()
+{
+    LcdVcdRecorder vcd;
+    BusSignals bus(vcd);
+    lcd_host_attach(&vcd);
+    frame_occupancy(vcd, bus);
+    lcd_host_detach(&vcd);
+
+    FILE* file = tmpfile();
+    CHECK(file != nullptr);
+    if (file == nullptr)
+    {
+        return;
+    }
+    CHECK(vcd.write_vcd(file));
+    rewind(file);
+
+    char line[128];
+    size_t vars = 0, values = 0, stamps = 0;
+    bool definitions = false;
+    while (fgets(line, sizeof(line), file) != nullptr)
+    {
+        if (strncmp(line, "$var wire 1 ", 12) == 0)
+        {
+            vars++;
+        }
+        else if (strcmp(line, "$enddefinitions $end\n") == 0)
+        {
+            definitions = true;
+        }
+        else if (line[0] == '#')
+        {
+            stamps++;
+        }
+        else if (definitions && (line[0] == '0' || line[0] == '1'))
+        {
+            values++;
+        }
+    }
+    fclose(file);
+
+    CHECK(definitions);
+    CHECK(vars == 5);
+    CHECK(values == 5 + vcd.changes().size());
+    CHECK(stamps > 1);
+}
+
+/* A recording holds one signal per printable VCD identifier code and refuses more. */
+static void test_signal_limit()
+{
+    LcdVcdRecorder vcd;
+    uint8_t last = 0;
+    for (uint8_t i = 0; i < LcdVcdRecorder::MAX_SIGNALS; i++)
+    {
+        last = vcd.add_signal("PIN", {1, GPIO_PIN_0});
+    }
+    CHECK(last == LcdVcdRecorder::MAX_SIGNALS - 1);
+    CHECK(vcd.add_signal("EXTRA", {1, GPIO_PIN_1}) == LcdVcdRecorder::NO_SIGNAL);
+    CHECK(vcd.low_time_ns(LcdVcdRecorder::NO_SIGNAL) == 0);
+}
+
+int main()
+{
+    test_virtual_clock();
+    test_frame_waveform();
+    test_cost_model();
+    test_transport_toggles();
+    test_vcd_file();
+    test_signal_limit();
+    return lcd_test_result("vcd_test");
+}
@@ -0,0 +1,205 @@
+
+/**
+ * @file LcdBsrrTransport.hpp
+ * @brief This file contains the compile-time pin descriptors and the BSRR bit-bang transport.
+ *
+ * LcdBsrrTransport bit-bangs the PCD8544 serial interface by writing the GPIO BSRR registers
+ * directly. All ports and pin masks are template parameters, so every pin write compiles to a
+ * single store of a constant and the byte loop is fully unrolled. When DIN and CLK share a
+ * port, the data bit and the CLK falling edge are written with one store.
+ *
+ * @author Ömer Gökyer
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <utility>
+
+#include "LcdTransport.hpp"
+
+/**
+ * @brief GPIO ports that can carry an LCD pin.
+ */
+enum class LcdPort : uint8_t {
+
+    A, B, C, D, E, F, G, H, I
+};
+
+/**
+ * @brief Returns the register block of a GPIO port.
+ *
+ * The STM32F4 GPIO ports are mapped 0x400 bytes apart starting at GPIOA_BASE, so the
+ * address folds to a constant when the port is known at compile time. The host build has
+ * no register map and uses the recorded ports of its HAL stand-in instead.
+ *
+ * @param port The GPIO port.
+ * @return Pointer to the GPIO register block.
+ */
+inline GPIO_TypeDef* lcd_port(LcdPort port){
+
+#ifdef LCD_HOST_BUILD
+    return &lcd_host_gpio[static_cast<uint8_t>(port)];
+#else
+    return reinterpret_cast<GPIO_TypeDef*>(GPIOA_BASE + static_cast<uint32_t>(port) * 0x400U);
+#endif
+}
+
+/**
+ * @brief Compile-time descriptor of one GPIO pin.
+ *
+ * @tparam Port The GPIO port of the pin.
+ * @tparam Pin The pin mask, for example GPIO_PIN_14.
+ *
+ * @usage
+ * using RstPin = LcdPin<LcdPort::B, GPIO_PIN_14>;
+ * RstPin::write(true);
+ */
+template <LcdPort Port, uint16_t Pin>
+struct LcdPin {
+
+    static constexpr LcdPort port = Port;
+    static constexpr uint32_t set_mask = Pin;
+    static constexpr uint32_t reset_mask = static_cast<uint32_t>(Pin) << 16;
+
+    static_assert(Pin != 0 && (Pin & (Pin - 1)) == 0, "LcdPin needs a single GPIO_PIN_x mask");
+
+    /**
+     * @brief Drives the pin with a single BSRR store.
+     *
+     * @param level True for a high level, false for a low level.
+     */
+    static void write(bool level){
+
+        lcd_port(Port)->BSRR = level ? set_mask : reset_mask;
+    }
+};
+
+/**
+ * @brief Bit-banged transport writing GPIOx->BSRR directly with compile-time pins.
+ *
+ * The PCD8544 accepts a serial clock of at most 4 MHz and samples DIN on the rising edge, so each
+ * CLK low and CLK high phase has to last at least 125 ns. Back-to-back BSRR stores are much faster
+ * than that, and a NOP is not guaranteed to take any time on a Cortex-M4, so every half period
+ * waits on the DWT cycle counter until CoreClockHz / 8 MHz cycles (21 at 168 MHz) have passed since
+ * the CLK edge. The constructor starts the counter. Where it does not run (QEMU, or a debugger that
+ * cleared TRCENA), the wait gives up after the same number of counter reads, each of which takes
+ * at least one cycle, so the half period still lasts at least 125 ns.
+ *
+ * @tparam RST Pin descriptor (LcdPin) of the reset line.
+ * @tparam CE Pin descriptor of the chip enable line.
+ * @tparam DC Pin descriptor of the data/command line.
+ * @tparam DIN Pin descriptor of the serial data line.
+ * @tparam CLK Pin descriptor of the serial clock line.
+ * @tparam CoreClockHz Core clock (HCLK) of the MCU in Hz; set it when the core does not run at 168 MHz.
+ *
+ * @usage
+ * LcdBsrrTransport<LcdPin<LcdPort::B, GPIO_PIN_14>, LcdPin<LcdPort::B, GPIO_PIN_13>,
+ *                  LcdPin<LcdPort::B, GPIO_PIN_12>, LcdPin<LcdPort::B, GPIO_PIN_10>,
+ *                  LcdPin<LcdPort::B, GPIO_PIN_11>> bus;
+ * LcdDriver lcd(bus);
+ */
+template <typename RST, typename CE, typename DC, typename DIN, typename CLK, uint32_t CoreClockHz = 168000000U>
+class LcdBsrrTransport : public LcdTransport {
+
+    public:
+
+        /**
+         * @brief Starts the DWT cycle counter that paces the clock.
+         */
+        LcdBsrrTransport(){
+
+            SET_BIT(CoreDebug->DEMCR, CoreDebug_DEMCR_TRCENA_Msk);
+            SET_BIT(DWT->CTRL, DWT_CTRL_CYCCNTENA_Msk);
+        }
+
+        /**
+         * @brief Drives one of the LCD lines with a single BSRR store.
+         *
+         * @param line The line to drive.
+         * @param level True for a high level, false for a low level.
+         */
+        void set_line(LcdLine line, bool level) override {
+
+            switch (line){
+
+                case LcdLine::RST: RST::write(level); break;
+                case LcdLine::CE:  CE::write(level); break;
+                case LcdLine::DC:  DC::write(level); break;
+                case LcdLine::DIN: DIN::write(level); break;
+                case LcdLine::CLK: CLK::write(level); break;
+            }
+        }
+
+        /**
+         * @brief Sends bytes to the LCD, MSB first, with an unrolled bit loop.
+         *
+         * @param data Pointer to the bytes to send.
+         * @param length The number of bytes to send.
+         */
+        void send(const uint8_t* data, uint16_t length) override {
+
+            for (uint16_t n = 0; n < length; n++){
+
+                send_byte(data[n]);
+            }
+        }
+
+        /**
+         * @brief Sends one byte to the LCD, MSB first.
+         *
+         * @param byte The byte to send.
+         */
+        static inline void send_byte(uint8_t byte){
+
+            [byte]<size_t... Bit>(std::index_sequence<Bit...>){
+
+                (send_bit((byte >> (7 - Bit)) & 0x01), ...);
+            }(std::make_index_sequence<8>{});
+        }
+
+    private:
+
+        /**
+         * @brief Puts one bit on DIN, then produces a rising CLK edge.
+         *
+         * DIN changes together with the CLK falling edge. If both pins are on the same port
+         * this is a single BSRR store.
+         *
+         * @param bit The bit to send (0 or 1).
+         */
+        static inline void send_bit(int bit){
+
+            if constexpr (DIN::port == CLK::port){
+
+                lcd_port(CLK::port)->BSRR = (bit ? DIN::set_mask : DIN::reset_mask) | CLK::reset_mask;
+            }
+            else {
+
+                DIN::write(bit != 0);
+                CLK::write(false);
+            }
+            settle();
+            CLK::write(true);
+            settle();
+        }
+
+        /** Core clock cycles in the shortest CLK low or high time of 125 ns. */
+        static constexpr uint32_t half_period_cycles = (CoreClockHz + 7999999U) / 8000000U;
+
+        /**
+         * @brief Waits half a clock period after a CLK edge.
+         */
+        static inline void settle(){
+
+            const uint32_t start = DWT->CYCCNT;
+            for (uint32_t n = 0; n < half_period_cycles; n++){
+
+                if (static_cast<uint32_t>(DWT->CYCCNT) - start >= half_period_cycles){
+
+                    break;
+                }
+                __NOP();
+            }
+        }
+};
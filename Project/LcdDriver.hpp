@@ -12,54 +12,104 @@
  * @version 1.0
  */
 
+#pragma once
+
 #include <stdint.h>
 #include <string.h>
 
-#include "stm32f4xx_hal.h"
+#include "LcdHal.hpp"
+#include "LcdTransport.hpp"
+#include "LcdFlushPlanner.hpp"
+#include "LcdStats.hpp"
+#include "LcdGlyphCache.hpp"
+#include "LcdTrace.hpp"
 #include "font.h"
 #include "custom_char.h"
 
+/**
+ * Number of frame buffers. With 1 (the default) draw calls and flushes share one buffer.
+ * With 2 (double buffering) or 3 (triple buffering) draw calls go to a back buffer and
+ * swap() hands it to the flush engine as the new front buffer.
+ */
+#ifndef LCD_FRAMEBUFFER_COUNT
+#define LCD_FRAMEBUFFER_COUNT 1
+#endif
+
+static_assert(LCD_FRAMEBUFFER_COUNT >= 1 && LCD_FRAMEBUFFER_COUNT <= 3, "LCD_FRAMEBUFFER_COUNT must be 1, 2 or 3");
+
+/**
+ * @brief When draw calls send their changes to the LCD.
+ */
+enum class LcdFlushPolicy : uint8_t {
+
+    PerCall,    /**< Each print_buffer(), put_char_xy(), draw_bitmap() and fill/clear/invert_rect() call flushes the area it changed. */
+    Manual      /**< Draw calls only change the buffer; call flush() or end_frame(). */
+};
+
+/**
+ * @brief How a bitmap, glyph or custom character is combined with the buffer.
+ * 
+ * Only the pixels inside the drawn rectangle are affected; s is the source pixel, d the pixel
+ * in the buffer.
+ */
+enum class LcdRasterOp : uint8_t {
+
+    Copy,       /**< d = s: the rectangle shows the source, set and clear pixels alike. */
+    Or,         /**< d = d | s: set pixels are drawn over the buffer. The default. */
+    And,        /**< d = d & s: clears the buffer where the source is clear. */
+    Xor,        /**< d = d ^ s: toggles; drawing the same thing twice restores the buffer. */
+    Not,        /**< d = !s: the rectangle shows the inverted source. */
+    Clear       /**< d = d & !s: erases the pixels set in the source, as used by invert(true). */
+};
+
 class LcdDriver {
 
     public:
 
+        /**
+         * @brief Creates an LCD driver that bit-bangs the display through runtime GPIO pins.
+         * 
+         * The pins are assigned afterwards with set_pin(). When the pins are known at compile
+         * time, prefer LcdBsrrTransport, which avoids the HAL call overhead.
+         */
+        LcdDriver() : transport(&gpio_transport) {}
+
+        /**
+         * @brief Creates an LCD driver that talks to the display through the given transport.
+         * 
+         * The transport must outlive the driver. Use this constructor to select a hardware
+         * backend such as LcdSpiTransport instead of the default bit-banged GPIO transport.
+         * 
+         * @param bus The transport used to drive the display.
+         * 
+         * @usage
+         * LcdSpiTransport spi(&hspi2);
+         * LcdDriver lcd(spi);
+         */
+        explicit LcdDriver(LcdTransport& bus) : transport(&bus) {}
+
+        LcdDriver(const LcdDriver&) = delete;
+        LcdDriver& operator=(const LcdDriver&) = delete;
+
         /**
          * @brief Sets the pin for a specific function in the LCD driver.
          * 
-         * This function allows you to set the pin for a specific function in the LCD driver.
-         * The available pin names are "RST", "CE", "DC", "DIN", and "CLK".
+         * This function assigns a GPIO pin to one of the LCD lines (RST, CE, DC, DIN or CLK) of the
+         * default bit-banged transport. The pin is forwarded to the transport, which ignores lines it
+         * does not drive through runtime GPIO pins (for example DIN and CLK on the SPI transport, or
+         * every line of LcdBsrrTransport, whose pins are fixed at compile time).
          * 
          * @param PORT The GPIO port to which the pin belongs.
          * @param PIN The pin number.
-         * @param pinName The name of the pin function. It can be "RST", "CE", "DC", "DIN", or "CLK".
+         * @param line The LCD line driven by the pin.
+         * 
+         * @usage
+         * lcd.set_pin(GPIOB, GPIO_PIN_14, LcdLine::RST);
          */
-        void set_pin(GPIO_TypeDef* PORT, uint16_t PIN, const char* pinName){
-
-            if (strcmp(pinName, "RST") == 0){
-
-                pins.RSTPORT = PORT;
-                pins.RSTPIN = PIN;
-            }
-            else if (strcmp(pinName, "CE") == 0){
+        void set_pin(GPIO_TypeDef* PORT, uint16_t PIN, LcdLine line){
 
-                pins.CEPORT = PORT;
-                pins.CEPIN = PIN;
-            }
-            else if (strcmp(pinName, "DC") == 0){
-
-                pins.DCPORT = PORT;
-                pins.DCPIN = PIN;
-            }
-            else if (strcmp(pinName, "DIN") == 0){
-
-                pins.DINPORT = PORT;
-                pins.DINPIN = PIN;
-            }
-            else if (strcmp(pinName, "CLK") == 0){
-
-                pins.CLKPORT = PORT;
-                pins.CLKPIN = PIN;
-            }
+            LCD_TRACE_SCOPE("set_pin", "api");
+            transport->set_pin(PORT, PIN, line);
         }
 
         /**
@@ -74,7 +124,7 @@ class LcdDriver {
          * 6. Sends basic commands to the LCD.
          * 7. Sets the LCD display to normal mode.
          * 8. Clears the LCD display.
-         * 9. Sets the inverttext flag to false.
+         * 9. Sets the raster op back to LcdRasterOp::Or.
          * 
          * @note This function assumes that the necessary GPIO pins and HAL library have been properly configured.
          * 
@@ -84,119 +134,321 @@ class LcdDriver {
          */
         void init(){
 
-            HAL_GPIO_WritePin(pins.RSTPORT, pins.RSTPIN, GPIO_PIN_RESET);
-            HAL_GPIO_WritePin(pins.RSTPORT, pins.RSTPIN, GPIO_PIN_SET);
+            LCD_TRACE_SCOPE("init", "api");
+#if LCD_ENABLE_STATS
+            lcd_stats_start_cycle_counter();
+#endif
+            transport->set_line(LcdLine::RST, false);
+            transport->set_line(LcdLine::RST, true);
+            dc_mode = LCD_MODE_UNKNOWN;
 
+            Transaction transaction(*this);
             write(0x21, LCD_COMMAND); // LCD extended commands
             write(0xB8, LCD_COMMAND); // Set LCD Vop(Contrast)
             write(0x04, LCD_COMMAND); // Set temp coefficent
             write(0x12, LCD_COMMAND); // LCD bias mode
-            write(0x20, LCD_COMMAND); // LCD basic commands
+            write(LCD_BASIC_FUNCTION_SET, LCD_COMMAND); // LCD basic commands
             write(LCD_DISPLAY_NORMAL, LCD_COMMAND); // LCD normal
 
             clear();
-            inverttext = false;
+            default_op = LcdRasterOp::Or;
+        }
+
+        /**
+         * @brief RAII guard that keeps the LCD selected for its lifetime.
+         * 
+         * Constructing a Transaction calls begin_transaction() and destroying it calls
+         * end_transaction(), so CE stays low across every write in the enclosing scope.
+         * 
+         * @usage
+         * {
+         *     LcdDriver::Transaction transaction(lcd);
+         *     lcd.print("12:30", 0, 0, FontLarge);
+         *     lcd.print("Temp", 0, 3, FontDefault);
+         * }
+         */
+        class Transaction {
+
+            public:
+
+                explicit Transaction(LcdDriver& driver) : lcd(driver) {
+
+                    lcd.begin_transaction();
+                }
+
+                ~Transaction(){
+
+                    lcd.end_transaction();
+                }
+
+                Transaction(const Transaction&) = delete;
+                Transaction& operator=(const Transaction&) = delete;
+
+            private:
+
+                LcdDriver& lcd;
+        };
+
+        /**
+         * @brief Starts a transaction: pulls CE low until the matching end_transaction().
+         * 
+         * Every write inside a transaction is sent without releasing CE, and the DC pin is only
+         * switched when the mode changes between command and data. Transactions nest; CE is
+         * released when the outermost transaction ends.
+         */
+        void begin_transaction(){
+
+            LCD_TRACE_SCOPE("begin_transaction", "api");
+            wait_flush();
+            if (transaction_depth++ == 0){
+
+                transport->set_line(LcdLine::CE, false);
+            }
         }
 
+        /**
+         * @brief Ends a transaction started with begin_transaction().
+         * 
+         * When the outermost transaction ends, the CE pin is set high again.
+         */
+        void end_transaction(){
+
+            LCD_TRACE_SCOPE("end_transaction", "api");
+            wait_flush();
+            if (transaction_depth > 0 && --transaction_depth == 0){
+
+                transport->set_line(LcdLine::CE, true);
+            }
+        }
+
+        /**
+         * @brief Selects when draw calls send their changes to the LCD.
+         * 
+         * With LcdFlushPolicy::PerCall (the default) print_buffer(), put_char_xy(), draw_bitmap(),
+         * fill_rect(), clear_rect() and invert_rect() flush the area they changed once per call. With LcdFlushPolicy::Manual draw calls only change the buffer and
+         * the application calls flush(), for example once per UI tick.
+         * 
+         * @param policy The flush policy.
+         */
+        void set_flush_policy(LcdFlushPolicy policy){
+
+            LCD_TRACE_SCOPE("set_flush_policy", "api");
+            flush_policy = policy;
+        }
+
+        /**
+         * @brief Starts a frame: draw calls only change the buffer until end_frame().
+         * 
+         * Frames nest; the changes of the whole frame are sent once when the outermost frame ends.
+         */
+        void begin_frame(){
+
+            LCD_TRACE_SCOPE("begin_frame", "api");
+            frame_depth++;
+        }
+
+        /**
+         * @brief Ends a frame started with begin_frame() and flushes its changes.
+         * 
+         * The flush happens when the outermost frame ends, regardless of the flush policy.
+         */
+        void end_frame(){
+
+            LCD_TRACE_SCOPE("end_frame", "api");
+            if (frame_depth > 0 && --frame_depth == 0){
+
+                flush();
+            }
+        }
+
+        /**
+         * @brief Sends every change made to the buffer since the last flush.
+         * 
+         * With more than one frame buffer this is swap().
+         */
+        void flush(){
+
+            LCD_TRACE_SCOPE("flush", "api");
+#if LCD_FRAMEBUFFER_COUNT > 1
+            swap();
+#else
+            refresh_dirty();
+#endif
+        }
+
+        /**
+         * @brief Makes the back buffer the front buffer and shows it on the LCD.
+         * 
+         * The flush engine only reads the front buffer and draw calls only write the back buffer,
+         * so the panel never shows a half drawn frame. After the swap the back buffer holds a copy
+         * of the new front buffer and drawing of the next frame can start right away.
+         * 
+         * With an asynchronous transport (see LcdTransport::async_capable()) the front buffer is
+         * sent in the background as a full frame. If the previous frame is still in flight, the new
+         * one is queued and sent from the completion interrupt; with three buffers a queued frame
+         * that has not started yet is replaced by the newer one instead of being waited for. With
+         * a blocking transport the changed areas are sent before swap() returns.
+         * 
+         * swap() only blocks when every buffer other than the new front is still being sent, which
+         * can only happen with two buffers.
+         * 
+         * @note With LCD_FRAMEBUFFER_COUNT set to 1 this is the same as refresh_dirty().
+         * 
+         * @usage
+         * // compile with -DLCD_FRAMEBUFFER_COUNT=2
+         * lcd.set_flush_policy(LcdFlushPolicy::Manual);
+         * while (1) {
+         *     lcd.clear();
+         *     lcd.print_buffer(label, 0, 0, FontDefault);
+         *     lcd.swap();
+         * }
+         */
+        void swap(){
+
+            LCD_TRACE_SCOPE("swap", "api");
+#if LCD_FRAMEBUFFER_COUNT > 1
+            present(transport->async_capable() ? Present::Async : Present::Dirty);
+#else
+            refresh_dirty();
+#endif
+        }
+
+        /**
+         * @brief RAII guard that groups draw calls into one frame.
+         * 
+         * @usage
+         * {
+         *     LcdDriver::Frame frame(lcd);
+         *     lcd.clear();
+         *     lcd.put_char_xy(menu_gui, 0, 0);
+         *     lcd.print_buffer("Omer", 20, 20, Default);
+         * }   // one flush here
+         */
+        class Frame {
+
+            public:
+
+                explicit Frame(LcdDriver& driver) : lcd(driver) {
+
+                    lcd.begin_frame();
+                }
+
+                ~Frame(){
+
+                    lcd.end_frame();
+                }
+
+                Frame(const Frame&) = delete;
+                Frame& operator=(const Frame&) = delete;
+
+            private:
+
+                LcdDriver& lcd;
+        };
+
         /**
          * @brief Clears the LCD display by setting all pixels to 0x00.
          * 
          * This function clears the LCD display by writing 0x00 to each pixel in the buffer.
-         * The buffer is then updated with the new pixel values.
+         * The blank buffer is sent to the LCD right away.
          * 
-         * @note This function does not update the physical LCD display. To update the display,
-         *       the `updateDisplay()` function should be called after clearing the buffer.
+         * @note Inside a frame, or with the LcdFlushPolicy::Manual policy, only the buffer is cleared
+         *       and the blank screen is sent with the next flush.
          * 
          */
         void clear(){
 
-            for (uint16_t i = 0; i < LCD_SIZE; i++){
+            LCD_TRACE_SCOPE("clear", "api");
+            {
+                LCD_STATS_ZONE(clear);
+                memset(buffer, 0x00, LCD_SIZE);
+            }
+            if (frame_depth > 0 || flush_policy == LcdFlushPolicy::Manual || streaming){
 
-                write(0x00, LCD_DATA);
-                buffer[i] = 0x00;
+                mark_dirty(0, LCD_SIZE - 1);
+                return;
             }
+#if LCD_FRAMEBUFFER_COUNT > 1
+            present(Present::Full);
+#else
+            write_frame(buffer);
+#endif
         }
 
         /**
          * @brief Prints a string on the LCD display using the buffer.
          * 
-         * This function prints a string on the LCD display using the buffer and the specified font data.
+         * This function prints a string on the LCD display using the buffer and the specified font.
          * The string is printed starting from the specified position (x, y) on the LCD display.
-         * The font data is provided as a 2D array of type T with dimensions N x M.
+         * The glyph size comes from the font descriptor at compile time. Characters the font does
+         * not have are drawn blank. Glyphs go to the buffer through blit(), at any y; text running
+         * past the right edge is clipped. With LCD_GLYPH_CACHE_SIZE above 0, glyphs already drawn at
+         * the same y % 8 come from the glyph cache. The glyphs are combined with the buffer by the
+         * raster op set with set_raster_op(), or by the one given.
          * 
          * @param str The string to be printed.
          * @param x The starting x position on the LCD display.
          * @param y The starting y position on the LCD display. This parameter should be in the range of 0 to 48.
-         * @param fontData The font data used for printing the string. It should be a 2D array of type T with dimensions N x M.
+         * @param font The font descriptor (see LcdFont).
          * 
          * @note This function assumes that the necessary GPIO pins and HAL library have been properly configured.
          * 
+         * The changed area is flushed once after the whole string has been drawn, or at end_frame()
+         * when called inside a frame (see set_flush_policy()).
+         * 
          * @usage
-         * lcd.print_buffer("Hello World!", 0, 0, fontData);
-         * lcd.refresh_screen();
+         * lcd.print_buffer("Hello World!", 0, 0, FontDefault);
          */
-        template <typename T, size_t N, size_t M>
-        void print_buffer(const char* str, uint8_t x, uint8_t y, const std::array<std::array<T, N>, M>& fontData) {
-
-            uint8_t char_width = N;
+        template <typename Font>
+        void print_buffer(const char* str, uint8_t x, uint8_t y, const Font& font) {
 
-            while (*str) {
+            print_buffer(str, x, y, font, default_op);
+        }
 
-                uint8_t shift_value = y%8; 
-                uint8_t affected_rows = find_affected_rows(y, fontData[0].size());
-                uint8_t bit_count = count_bits(affected_rows);  /* Find how many bits are 1 in affected_rows */
-                uint8_t new_data[char_width * bit_count]{0x00};
+        template <typename Font>
+        void print_buffer(const char* str, uint8_t x, uint8_t y, const Font& font, LcdRasterOp op) {
 
-                char c = *str;
-                if (c < ' ' || c > '~') { c = ' '; } // Unsupported character
-                
-                shift_data(fontData[c - ' '].data(), char_width, new_data, shift_value, bit_count);
-                write_to_buffer(x, affected_rows, (new_data), char_width, bit_count, false);
-                refresh_screen();
+            LCD_TRACE_SCOPE("print_buffer", "api");
+            while (*str && x < LCD_WIDTH) {
 
-                x += N; // Move to the next character position
+                LCD_STATS_ZONE(render);
+                draw_glyph(x, y, font.glyph_bytes(*str), Font::width, Font::height, op);
+                x = static_cast<uint8_t>(x + Font::width); // Move to the next character position
                 str++;
             }
+            auto_flush();
         }
 
         /**
          * @brief Prints a string on an LCD display using a custom font.
          * 
-         * This function prints a string on an LCD display using a custom font. The font data is provided as a 2D array of type T with dimensions N and M.
+         * This function prints a string straight to the LCD display, one bank row of the glyphs at a
+         * time. Fonts taller than 8 pixels span several banks starting at bank y; the number of banks
+         * is known from the font descriptor at compile time and each bank row is sent as it is
+         * stored in the glyph. Characters the font does not have are drawn blank.
          * 
          * @param str The string to be printed.
          * @param x The x-coordinate of the starting position.
          * @param y The y-coordinate of the starting position. This parameter should be in the range of 0 to 5.
-         * @param fontData The 2D array of font data.
+         * @param font The font descriptor (see LcdFont).
          * 
-         * @tparam T The type of the font data.
-         * @tparam N The number of columns in the font data.
-         * @tparam M The number of rows in the font data.
+         * @tparam Font The LcdFont type of the font.
          */
-        template <typename T, size_t N, size_t M>
-        void print(const char* str, uint8_t x, uint8_t y, const std::array<std::array<T, N>, M>& fontData) {
+        template <typename Font>
+        void print(const char* str, uint8_t x, uint8_t y, const Font& font) {
 
+            LCD_TRACE_SCOPE("print", "api");
+            Transaction transaction(*this);
             while (*str) {
 
-                char c = *str;
-                if (c < ' ' || c > '~') {
-
-                    c = ' '; // Unsupported character
-                }
-                
-                const std::array<T, N>& charData = fontData[c - ' '];
-                int shift = get_shift_value(fontData);
-                for (; shift >= 0; shift -= 8) {
-
-                    setXY(x, static_cast<uint8_t>(y + (shift / 8)));
-                    for (size_t i = 0; i < N; i++) {
+                LCD_STATS_ZONE(render);
+                const uint8_t* glyph = font.glyph_bytes(*str);
+                for (int bank = Font::banks - 1; bank >= 0; bank--) {
 
-                        uint8_t data = static_cast<uint8_t>((charData[i] >> shift) & 0xFF);
-                        write(data, LCD_DATA);
-                        
-                    }
+                    setXY(x, static_cast<uint8_t>(y + bank));
+                    write(glyph + (bank * Font::width), Font::width, LCD_DATA);
                 }
-                x += N; // Move to the next character position
+                x += Font::width; // Move to the next character position
                 str++;
             }
         }
@@ -213,8 +465,9 @@ class LcdDriver {
          */
         void setXY(uint8_t x, uint8_t y){
 
-            write(LCD_SETYADDR | y, LCD_COMMAND);
-            write(LCD_SETXADDR | x, LCD_COMMAND);
+            LCD_TRACE_SCOPE("setXY", "api");
+            uint8_t commands[2] = { static_cast<uint8_t>(LCD_SETYADDR | y), static_cast<uint8_t>(LCD_SETXADDR | x) };
+            write(commands, 2, LCD_COMMAND);
             _cursor_x = x;
             _cursor_y = y;
         }
@@ -234,40 +487,77 @@ class LcdDriver {
         /**
          * @brief Puts a character on the LCD screen at the specified coordinates.
          * 
-         * This function takes a custom character and its coordinates (x, y) as input and displays it on the LCD screen.
-         * The character is shifted vertically by the value of y modulo 8. The affected rows are determined by finding the rows
-         * in the LCDHEIGHT/8 range that are affected by the character. The affected rows are represented by a bit value of 1 in
-         * the affected_rows variable. The number of bits that are set to 1 in affected_rows is counted using the count_bits function.
-         * A new data array is created with a size of c.char_width * bit_count, initialized with 0x00. The character data is then
-         * shifted using the shift_data function, and the resulting data is written to the LCD buffer using the write_to_buffer function.
-         * Finally, the screen is refreshed to display the updated content.
+         * This function takes a custom character and its coordinates (x, y) as input and draws it into the
+         * buffer with blit(), so any y works: the character data is shifted by y modulo 8 one column word
+         * at a time. Finally, the changed part of the screen is refreshed to display the updated content,
+         * unless a frame is open or the flush policy is LcdFlushPolicy::Manual.
          * 
          * @tparam custom_char The type of the custom character.
-         * @param c The custom character to be displayed.
+         * @param c The custom character to be displayed. Its data is bank-major: char_width bytes per
+         *          8 pixel bank.
          * @param x The x-coordinate of the character on the LCD screen.
          * @param y The y-coordinate of the character on the LCD screen.
+         * @param op How the character is combined with the buffer; set_raster_op() when omitted.
          */
         template <typename custom_char>
-        void put_char_xy(custom_char c , uint8_t x, uint8_t y){
+        void put_char_xy(const custom_char& c, uint8_t x, uint8_t y){
+
+            put_char_xy(c, x, y, default_op);
+        }
+
+        template <typename custom_char>
+        void put_char_xy(const custom_char& c, uint8_t x, uint8_t y, LcdRasterOp op){
+
+            LCD_TRACE_SCOPE("put_char_xy", "api");
+            {
+                LCD_STATS_ZONE(render);
+                blit(x, y, c.data, c.char_width, c.char_height, op);
+            }
+
+            auto_flush();
+
+        }
 
-            /* Defining local verables */
-            uint8_t shift_value = y%8; 
-            uint8_t affected_rows = find_affected_rows(y, c.char_height); /* Find the affected rows using c.char_height and y in LCDHEIGHT/8 rows. Affected rows bit will be 1 in affeced_rows variable. */
-            uint8_t bit_count = count_bits(affected_rows); /* Find how many bits are 1 in affected_rows */
-            uint8_t new_data[c.char_width * bit_count]{0x00};
+        /**
+         * @brief Draws a bitmap at any position.
+         * 
+         * The bitmap is bank-major, like the display RAM: width bytes for each 8 pixel bank, top
+         * bank first, the top pixel of a bank in bit 0. It is combined with the buffer by a raster
+         * op; with the default of LcdRasterOp::Or, pixels set in the bitmap are set in the buffer
+         * and the others are left as they are. Parts outside the screen are clipped.
+         * 
+         * @param x The x-coordinate of the top-left corner.
+         * @param y The y-coordinate of the top-left corner, 0 to 47.
+         * @param bitmap The bitmap data, width * ceil(height / 8) bytes.
+         * @param width The width of the bitmap in pixels.
+         * @param height The height of the bitmap in pixels.
+         * @param op How the bitmap is combined with the buffer; set_raster_op() when omitted.
+         * 
+         * @usage
+         * static const uint8_t cursor[] = {0xFF, 0xFF};
+         * lcd.draw_bitmap(70, 3, cursor, 2, 8, LcdRasterOp::Xor);   // shows the cursor
+         * lcd.draw_bitmap(70, 3, cursor, 2, 8, LcdRasterOp::Xor);   // and hides it again
+         */
+        void draw_bitmap(uint8_t x, uint8_t y, const uint8_t* bitmap, uint8_t width, uint8_t height){
 
-            shift_data(c.data, c.char_width, new_data, shift_value, bit_count);
-            write_to_buffer(x, affected_rows, new_data, c.char_width, bit_count, false);
+            draw_bitmap(x, y, bitmap, width, height, default_op);
+        }
 
-            refresh_screen();
+        void draw_bitmap(uint8_t x, uint8_t y, const uint8_t* bitmap, uint8_t width, uint8_t height, LcdRasterOp op){
 
+            LCD_TRACE_SCOPE("draw_bitmap", "api");
+            {
+                LCD_STATS_ZONE(render);
+                blit(x, y, bitmap, width, height, op);
+            }
+            auto_flush();
         }
 
         /**
          * @brief Clears a specified area on the LCD screen.
          *
          * This function clears a rectangular area on the LCD screen starting from the specified coordinates (x, y) with the given width and height.
-         * It iterates over each pixel within the specified area and sets them to the inactive state.
+         * It works like clear_rect(): whole banks at a time, with one mask for the top and one for the bottom bank.
          *
          * @param x The x-coordinate of the top-left corner of the area.
          * @param y The y-coordinate of the top-left corner of the area.
@@ -276,261 +566,462 @@ class LcdDriver {
          */
         void clear_area(uint8_t x, uint8_t y, uint8_t width, uint8_t height){
 
-            for (uint8_t i = 0; i < height; i++){
+            LCD_TRACE_SCOPE("clear_area", "api");
+            LCD_STATS_ZONE(clear);
+            rect(x, y, width, height, LcdRasterOp::Not);
+        }
 
-                for (uint8_t j = 0; j < width; j++){
+        /**
+         * @brief Sets every pixel of a rectangle in the buffer.
+         *
+         * The rectangle is drawn one bank at a time: the top and bottom banks with a mask computed
+         * once, the banks in between with memset, so the cost follows the columns times the banks
+         * touched rather than the pixels. Whatever is outside the screen is clipped.
+         *
+         * @param x The x-coordinate of the top-left corner.
+         * @param y The y-coordinate of the top-left corner.
+         * @param width The width of the rectangle in pixels.
+         * @param height The height of the rectangle in pixels.
+         * @param op How the solid rectangle is combined with the buffer, LcdRasterOp::Or when omitted:
+         *           Copy and Or set the pixels, Not and Clear clear them, Xor inverts them and And keeps them.
+         *
+         * @usage
+         * lcd.fill_rect(0, 18, 84, 10);        // highlight bar
+         * lcd.invert(true);
+         * lcd.print_buffer("Settings", 2, 19, FontDefault);
+         * lcd.invert(false);
+         */
+        void fill_rect(int x, int y, int width, int height, LcdRasterOp op = LcdRasterOp::Or){
 
-                    set_pixel(x + j, y + i, false);
-                }
+            LCD_TRACE_SCOPE("fill_rect", "api");
+            {
+                LCD_STATS_ZONE(render);
+                rect(x, y, width, height, op);
             }
+            auto_flush();
         }
 
         /**
-         * @brief Writes data to the buffer of the LCD driver.
-         * 
-         * This function writes the specified data to the buffer of the LCD driver. The data is written starting from the specified x position and affects the specified rows in the buffer. The data is provided as an array of bytes, with each byte representing a column of pixels. The number of affected rows, the width of each character, the number of bits per column, and the character mode are also specified as parameters.
-         * 
-         * @param x The starting x position in the buffer.
-         * @param affected_rows The bitmask representing the affected rows in the buffer.
-         * @param new_data Pointer to the array of new data to be written.
-         * @param char_width The width of each character in pixels.
-         * @param bit_count The number of bits per column.
-         * @param char_mode The character mode flag.
-         * 
-         * @note The function assumes that the buffer and other necessary variables are already defined and accessible.
-         * @note The function modifies the buffer based on the provided parameters.
+         * @brief Clears every pixel of a rectangle in the buffer, the same way fill_rect() sets them.
          */
-        void write_to_buffer(int x, uint8_t affected_rows, const uint8_t* new_data, int char_width, uint8_t bit_count, bool char_mode) { 
+        void clear_rect(int x, int y, int width, int height){
 
-            int new_data_row = bit_count - 1;
-            for ( int i = 0; i < bit_count; i++){
+            LCD_TRACE_SCOPE("clear_rect", "api");
+            {
+                LCD_STATS_ZONE(clear);
+                rect(x, y, width, height, LcdRasterOp::Not);
+            }
+            auto_flush();
+        }
 
-                    volatile uint8_t row = 0;
-                    for ( int j = 7; j > -1; j--){
+        /**
+         * @brief Inverts every pixel of a rectangle in the buffer, the same way fill_rect() sets them.
+         *
+         * Inverting the same rectangle again restores it, which makes selection highlights cheap
+         * to move.
+         */
+        void invert_rect(int x, int y, int width, int height){
 
-                        if (affected_rows & (1 << j)){
+            LCD_TRACE_SCOPE("invert_rect", "api");
+            {
+                LCD_STATS_ZONE(render);
+                rect(x, y, width, height, LcdRasterOp::Xor);
+            }
+            auto_flush();
+        }
 
-                            row = j;
-                            // reset the bit
-                            affected_rows &= ~(1 << j);
-                            break;
-                        }
-                    }
-                    
-                    for (int j = 0; j < char_width; j++) {
-                        
-                        if (inverttext && char_mode) {
+        /**
+         * @brief Refreshes the screen by writing the contents of the buffer to the LCD.
+         * 
+         * This function sets the X and Y address of the LCD and then writes the contents of the buffer
+         * to the LCD in a single transfer. The buffer is a 1-dimensional array representing the pixels
+         * of the LCD screen, stored row by row in the same order the LCD auto-increments its address.
+         * 
+         * With more than one frame buffer the back buffer is swapped to the front first, as with
+         * swap(), and the whole front buffer is sent.
+         * 
+         * @note This function assumes that the `setXY` and `write` functions are properly implemented
+         * and accessible within the scope of this function.
+         */
+        void refresh_screen(){
 
-                            buffer[x + (row * LCD_WIDTH) + j] |= ~(new_data[j + (new_data_row * char_width)]);
-                        }
-                        if (inverttext && !char_mode) {
+            LCD_TRACE_SCOPE("refresh_screen", "api");
+#if LCD_FRAMEBUFFER_COUNT > 1
+            present(Present::Full);
+#else
+            if (streaming){
 
-                            buffer[x + (row * LCD_WIDTH) + j] &= ~(new_data[j + (new_data_row * char_width)]);
-                        }
-                        else {
-                            buffer[x + (row * LCD_WIDTH) + j] |= new_data[j + (new_data_row * char_width)];
-                        }
-                    }
-                    new_data_row--;
-                }
+                clear_dirty();
+                return;
+            }
+            write_frame(buffer);
+#endif
         }
 
         /**
-         * @brief Shifts the data in the given array by the specified shift value.
+         * @brief Refreshes only the parts of the screen that changed since the last refresh.
          * 
-         * This function is used to shift the data in the input array by the specified shift value. The shifted data is stored in the output array.
+         * Every draw routine records the column range it touched in each of the 6 banks. This
+         * function sends only those ranges, so updating one label moves tens of bytes instead of 504.
          * 
-         * @param data The input array containing the data to be shifted.
-         * @param char_width The width of each character in the data array.
-         * @param new_data The output array to store the shifted data.
-         * @param shift_value The number of bits to shift the data by.
-         * @param bit_count The number of bits in each character of the data array.
+         * The byte stream is planned by LcdFlushPlanner: short clean gaps between dirty bytes are
+         * sent along instead of re-addressing with setXY, and tall narrow updates (a bar graph or a
+         * cursor column) switch the LCD to vertical addressing for the flush when that is cheaper.
          * 
-         * @note The function assumes that the input and output arrays have sufficient memory allocated.
+         * With more than one frame buffer the back buffer is swapped to the front first and the
+         * changed areas are sent from the front buffer, with blocking writes.
          * 
-         * @return None.
+         * @note The dirty ranges only track changes made through the buffer. Text drawn directly
+         *       with print() is not part of the buffer and is left untouched.
+         * 
+         * @usage
+         * lcd.print_buffer("42", 60, 0, FontDefault);
+         * lcd.refresh_dirty();
          */
-        void shift_data(const uint8_t* data, uint8_t char_width, uint8_t* new_data, uint8_t shift_value, uint8_t bit_count){  
+        void refresh_dirty(){
 
-            if ( shift_value == 0 ){
+            LCD_TRACE_SCOPE("refresh_dirty", "api");
+#if LCD_FRAMEBUFFER_COUNT > 1
+            present(Present::Dirty);
+#else
+            restore_failed_flush();
+            if (streaming){
 
-                for (int i = 0; i < char_width; i++) {
-
-                    for (int j = 0; j < bit_count; j++) {
-
-                        new_data[i + (j * char_width)] = data[i + (j * char_width)];
-                    }
-                }
+                clear_dirty();
                 return;
             }
-    
-            else if ( bit_count != 1 ){
+            flush_planned(buffer);
+#endif
+        }
 
-                for (int i = 0; i < char_width; i++) {
+        /**
+         * @brief Tells whether the buffer has changes that are not on the screen yet.
+         * 
+         * @return True if refresh_dirty() would send any data.
+         */
+        bool is_dirty() const {
 
-                    for (int j = bit_count - 1; j > 0; j--) {
+            if (flush_failed){
 
-                        new_data[i + (j * char_width)] |= (data[i + ((j - 1) * char_width)] >> (8 - shift_value));
-                        new_data[i + ((j - 1) * char_width)] |= (data[i + ((j - 1) * char_width)] << shift_value);
-                    }
-                }
-                return;
+                return true;
             }
-            else {
+            for (uint8_t bank = 0; bank < LCD_BANKS; bank++){
 
-                // 8 bitlik verileri shift_value kadar kaydır
-                for (int i = 0; i < char_width; i++) {
+                if (dirty_first[bank] <= dirty_last[bank]){
 
-                    new_data[i] = (data[i] >> shift_value);
+                    return true;
                 }
-                return;
             }
-            
+            return false;
         }
 
         /**
-         * @brief Refreshes the screen by writing the contents of the buffer to the LCD.
+         * @brief Starts refreshing the screen in the background and returns immediately.
          * 
-         * This function sets the X and Y address of the LCD and then writes the contents of the buffer
-         * to the LCD in a row-by-row manner. The buffer is a 1-dimensional array representing the pixels
-         * of the LCD screen. The function iterates over each row and writes the corresponding pixels to
-         * the LCD.
+         * The buffer is copied into a separate transmit buffer, the LCD address is reset and the
+         * copy is handed to the transport with send_async(). Drawing may continue right away:
+         * draw calls only touch the buffer, never the copy being transmitted, so the frame on the
+         * panel cannot tear. Any other LCD write waits until the flush has completed.
          * 
-         * @note This function assumes that the `setXY` and `write` functions are properly implemented
-         * and accessible within the scope of this function.
+         * With a DMA capable transport (LcdSpiTransport with a TX DMA stream) this costs one
+         * 504 byte copy of CPU time. Other transports complete the flush before returning.
+         * 
+         * With more than one frame buffer no copy is made: the back buffer is swapped to the front
+         * and sent as with swap().
+         * 
+         * @param callback Function called once the flush has completed. It may run in interrupt
+         *                 context. May be nullptr.
+         * @param context Pointer passed back to the callback.
+         * @return True if the flush was started, false if a previous flush is still in flight or
+         *         the buffer is being streamed.
+         * 
+         * @usage
+         * lcd.print_buffer("Hello", 0, 0, FontDefault);
+         * lcd.refresh_screen_async();
+         * // ... control loop keeps running ...
+         * if (!lcd.is_flushing()) { ... }
          */
-        void refresh_screen(){
+        bool refresh_screen_async(LcdTransferCallback callback = nullptr, void* context = nullptr){
 
-            setXY(LCD_SETXADDR, LCD_SETYADDR);
-            for(int i = 0; i < 6; i++){
+            LCD_TRACE_SCOPE("refresh_screen_async", "api");
+            if (flush_busy || streaming){
 
-                for(int j = 0; j < LCD_WIDTH; j++){
-                write(buffer[(i * LCD_WIDTH) + j], LCD_DATA);
-                }
+                return false;
             }
+            flush_callback = callback;
+            flush_context = context;
+#if LCD_FRAMEBUFFER_COUNT > 1
+            present(Present::Async);
+#else
+            restore_failed_flush();
+            memcpy(flush_buffer, buffer, LCD_SIZE);
+            clear_dirty();
+            start_flush(flush_buffer);
+#endif
+            return true;
         }
 
         /**
-         * @brief Inverts the display mode of the LCD driver.
+         * @brief Tells whether a flush started with refresh_screen_async() is still in flight.
          * 
-         * This function allows the user to invert the display mode of the LCD driver.
-         * When the mode is set to true, the display will be inverted. When the mode is set to false,
-         * the display will be normal.
-         * 
-         * @param mode The display mode to set. True for inverted display, false for normal display.
+         * @return True while the flush is running, false once it has completed.
          */
-        void invert(bool mode){
+        bool is_flushing() const {
 
-            inverttext = mode;
+            return flush_busy;
         }
 
         /**
-         * @brief Sets the value of a pixel at the specified coordinates.
-         *
-         * This function sets the value of a pixel at the specified coordinates in the LCD buffer.
-         * The pixel is represented by a boolean value, where true represents an "on" pixel and false represents an "off" pixel.
-         *
-         * @param x The x-coordinate of the pixel.
-         * @param y The y-coordinate of the pixel.
-         * @param value The value to set for the pixel (true for "on", false for "off").
+         * @brief Blocks until a flush started with refresh_screen_async() or swap() has completed.
          */
-        void set_pixel(uint8_t x, uint8_t y, bool value){
-
-            if(value){
-
-                buffer[x + (y / 8) * LCD_WIDTH] |= 1 << (y % 8);
-            }
-            else{
+        void wait_flush(){
 
-                buffer[x + (y / 8) * LCD_WIDTH] &= ~(1 << (y % 8));
+            LCD_TRACE_SCOPE("wait_flush", "api");
+            while (flush_busy){
             }
+            restore_failed_flush();
         }
 
         /**
-         * @brief Draws a horizontal line on the LCD screen.
+         * @brief Starts mirroring the buffer to the LCD continuously without CPU involvement.
          * 
-         * This function draws a horizontal line on the LCD screen starting from the specified coordinates (x, y) with the specified length (l).
-         * The line is drawn by setting the corresponding bits in the buffer array.
+         * The transport sends the buffer over and over with circular DMA; the LCD address counter
+         * wraps to (0, 0) after the last byte, so every pass lands on the whole screen. Drawing
+         * then only changes memory and refresh_dirty(), flush() and refresh_screen() have nothing
+         * left to do. Command writes (init(), setXY() or any other LCD_COMMAND write) stop the
+         * stream, are sent, and restart it from (0, 0).
          * 
-         * @param x The x-coordinate of the starting point of the line.
-         * @param y The y-coordinate of the starting point of the line.
-         * @param l The length of the line to be drawn.
+         * The panel may show a pass that was read while a draw call was half done. With more than
+         * one frame buffer, swap() moves the stream to the new front buffer instead.
+         * 
+         * Bound the refresh rate with LcdSpiTransport::limit_stream_rate() before starting.
+         * 
+         * @return True if the stream is running, false if the transport cannot stream.
+         * 
+         * @usage
+         * LcdSpiTransport spi(&hspi2);   // with DMA1 Stream4 linked
+         * LcdDriver lcd(spi);
+         * lcd.init();
+         * spi.limit_stream_rate(60, 504);
+         * lcd.start_streaming();
+         * lcd.print_buffer("42", 60, 0, FontDefault);   // visible on the next pass
          */
-        void draw_H_line(int x, int y, int l){
-            
-            int by, bi;
-            if ((x>=0) && (x<LCD_WIDTH) && (y>=0) && (y<LCD_HEIGHT)){
+        bool start_streaming(){
 
-                for (int cx=0; cx<l; cx++){
+            LCD_TRACE_SCOPE("start_streaming", "api");
+            if (streaming){
 
-                    by=((y/8)*84)+x;
-                    bi=y % 8;
-                    buffer[by+cx] |= (1<<bi);
-                }
+                return true;
             }
+            wait_flush();
+            begin_transaction();
+            stream_source = buffer;
+            resume_stream();
+            if (!streaming){
+
+                end_transaction();
+                return false;
+            }
+            clear_dirty();
+            return true;
         }
 
         /**
-         * @brief Draws a vertical line on the LCD screen.
-         * 
-         * This function draws a vertical line on the LCD screen starting from the specified coordinates (x, y) and extending downwards for a given length.
+         * @brief Stops the stream started with start_streaming().
          * 
-         * @param x The x-coordinate of the starting point of the line.
-         * @param y The y-coordinate of the starting point of the line.
-         * @param l The length of the line to be drawn.
+         * The stream may stop in the middle of a pass; the buffer is then marked dirty so that the
+         * next flush completes the screen.
+         */
+        void stop_streaming(){
+
+            LCD_TRACE_SCOPE("stop_streaming", "api");
+            if (!streaming){
+
+                return;
+            }
+            transport->stop_stream();
+            streaming = false;
+            end_transaction();
+            mark_dirty(0, LCD_SIZE - 1);
+        }
+
+        /**
+         * @brief Tells whether the buffer is being streamed to the LCD.
          * 
-         * @note The function only draws the line if the starting coordinates (x, y) are within the valid range of the LCD screen (0 <= x < 84, 0 <= y < 48).
+         * @return True between start_streaming() and stop_streaming().
          */
-        void draw_V_line(int x, int y, int l){
+        bool is_streaming() const {
 
-            if ((x>=0) && (x<84) && (y>=0) && (y<48)){
+            return streaming;
+        }
 
-                for (int cy=0; cy<= l; cy++){
+        /**
+         * @brief Returns the running statistics of the driver.
+         * 
+         * The figures are collected when LCD_ENABLE_STATS is 1 (see LcdStats.hpp). Otherwise the
+         * instrumentation is compiled out and every figure reads 0.
+         * 
+         * @usage
+         * const LcdStats& stats = lcd.stats();
+         * telemetry.report(stats.frames_flushed, stats.flush.worst_cycles, stats.flush.average_cycles());
+         */
+        const LcdStats& stats() const {
+
+#if LCD_ENABLE_STATS
+            return stats_data;
+#else
+            static const LcdStats none{};
+            return none;
+#endif
+        }
 
-                    set_pixel(x, y+cy, true);
-                }
-            }
+        /**
+         * @brief Sets every counter and zone of stats() back to 0.
+         */
+        void reset_stats(){
+
+            LCD_TRACE_SCOPE("reset_stats", "api");
+#if LCD_ENABLE_STATS
+            uint32_t primask = enter_critical();
+            stats_data = LcdStats{};
+            exit_critical(primask);
+#endif
         }
 
+        /**
+         * @brief Returns the hit and miss counters of the glyph cache.
+         * 
+         * The cache exists when LCD_GLYPH_CACHE_SIZE is above 0 (see LcdGlyphCache.hpp). Otherwise
+         * both counters read 0.
+         */
+        const LcdGlyphCacheStats& glyph_cache_stats() const {
+
+#if LCD_GLYPH_CACHE_SIZE > 0
+            return glyph_cache.stats();
+#else
+            static const LcdGlyphCacheStats none{};
+            return none;
+#endif
+        }
 
-    private:
+        /**
+         * @brief Empties the glyph cache and zeroes its counters.
+         */
+        void clear_glyph_cache(){
+
+            LCD_TRACE_SCOPE("clear_glyph_cache", "api");
+#if LCD_GLYPH_CACHE_SIZE > 0
+            glyph_cache.clear();
+#endif
+        }
 
         /**
-         * @brief Reverses the bits of a given 8-bit number.
+         * @brief Sets the raster op of the draw calls that do not name one.
          * 
-         * This function takes an 8-bit number as input and reverses the order of its bits.
-         * The reversed number is then returned.
+         * @param op How print_buffer(), put_char_xy() and draw_bitmap() combine their pixels with
+         *           the buffer from now on. LcdRasterOp::Or after init().
+         */
+        void set_raster_op(LcdRasterOp op){
+
+            LCD_TRACE_SCOPE("set_raster_op", "api");
+            default_op = op;
+        }
+
+        /**
+         * @brief Returns the raster op of the draw calls that do not name one.
+         */
+        LcdRasterOp raster_op() const {
+
+            return default_op;
+        }
+
+        /**
+         * @brief Inverts the text drawn from now on.
+         * 
+         * This function allows the user to invert the drawing mode of the LCD driver.
+         * When the mode is set to true, the pixels of text and characters are cleared instead of set
+         * (LcdRasterOp::Clear), which shows them inverted over a filled area such as a highlight bar
+         * and erases them elsewhere. When the mode is set to false, they are drawn normally
+         * (LcdRasterOp::Or). To draw a whole inverted cell, use LcdRasterOp::Not.
          * 
-         * @param n The 8-bit number to reverse the bits of.
-         * @return The reversed number with the bits in reverse order.
+         * @param mode The drawing mode to set. True for inverted text, false for normal text.
          */
-        uint8_t reverse_bits(uint8_t n) {
+        void invert(bool mode){
 
-            n = (n & 0xF0) >> 4 | (n & 0x0F) << 4;
-            n = (n & 0xCC) >> 2 | (n & 0x33) << 2;
-            n = (n & 0xAA) >> 1 | (n & 0x55) << 1;
-            return n;
+            LCD_TRACE_SCOPE("invert", "api");
+            default_op = mode ? LcdRasterOp::Clear : LcdRasterOp::Or;
         }
-        
+
         /**
-         * @brief Sends a byte of data to the LCD driver.
+         * @brief Sets the value of a pixel at the specified coordinates.
          *
-         * This function sends a byte of data to the LCD driver using the specified pins.
-         * It writes the data bit by bit, starting from the most significant bit (MSB) to the least significant bit (LSB).
+         * This function sets the value of a pixel at the specified coordinates in the LCD buffer.
+         * The pixel is represented by a boolean value, where true represents an "on" pixel and false represents an "off" pixel.
          *
-         * @param data The byte of data to be sent.
+         * @param x The x-coordinate of the pixel.
+         * @param y The y-coordinate of the pixel.
+         * @param value The value to set for the pixel (true for "on", false for "off").
+         */
+        void set_pixel(uint8_t x, uint8_t y, bool value){
+
+            LCD_TRACE_SCOPE("set_pixel", "api");
+            mark_dirty(static_cast<uint16_t>(x + (y / 8) * LCD_WIDTH), static_cast<uint16_t>(x + (y / 8) * LCD_WIDTH));
+            if(value){
+
+                buffer[x + (y / 8) * LCD_WIDTH] |= static_cast<uint8_t>(1u << (y % 8));
+            }
+            else{
+
+                buffer[x + (y / 8) * LCD_WIDTH] &= static_cast<uint8_t>(~(1u << (y % 8)));
+            }
+        }
+
+        /**
+         * @brief Draws a horizontal line on the LCD screen.
+         * 
+         * This function draws a horizontal line on the LCD screen starting from the specified coordinates (x, y) with the specified length (l).
+         * The line is a rectangle one pixel high, drawn by the same engine as fill_rect() and clipped at the right edge.
+         * 
+         * @param x The x-coordinate of the starting point of the line.
+         * @param y The y-coordinate of the starting point of the line.
+         * @param l The length of the line to be drawn.
+         */
+        void draw_H_line(int x, int y, int l){
+            
+            LCD_TRACE_SCOPE("draw_H_line", "api");
+            if ((x>=0) && (x<LCD_WIDTH) && (y>=0) && (y<LCD_HEIGHT)){
+
+                rect(x, y, l, 1, LcdRasterOp::Or);
+            }
+        }
+
+        /**
+         * @brief Draws a vertical line on the LCD screen.
+         * 
+         * This function draws a vertical line on the LCD screen starting from the specified coordinates (x, y) and extending downwards for a given length.
+         * The line is a rectangle one pixel wide, drawn by the same engine as fill_rect(): one byte per bank.
+         * 
+         * @param x The x-coordinate of the starting point of the line.
+         * @param y The y-coordinate of the starting point of the line.
+         * @param l The number of pixels below the starting point; the line covers l + 1 pixels and is clipped at the bottom edge.
+         * 
+         * @note The function only draws the line if the starting coordinates (x, y) are within the valid range of the LCD screen (0 <= x < 84, 0 <= y < 48).
          */
-        void send(uint8_t data){
+        void draw_V_line(int x, int y, int l){
 
-            for (int i = 0; i < 8; i++){
+            LCD_TRACE_SCOPE("draw_V_line", "api");
+            if ((x>=0) && (x<84) && (y>=0) && (y<48)){
 
-                HAL_GPIO_WritePin(pins.DINPORT, pins.DINPIN, (data & 0x80) ? GPIO_PIN_SET : GPIO_PIN_RESET);
-                HAL_GPIO_WritePin(pins.CLKPORT, pins.CLKPIN, GPIO_PIN_RESET);
-                HAL_GPIO_WritePin(pins.CLKPORT, pins.CLKPIN, GPIO_PIN_SET);
-                data <<= 1;
+                rect(x, y, 1, l + 1, LcdRasterOp::Or);
             }
         }
 
+
+    private:
+
+        /* The host benchmarks (Host/Bench) time the private rendering kernels directly. */
+        friend class LcdDriverBench;
+
         /**
          * @brief Writes data to the LCD driver.
          * 
@@ -543,220 +1034,734 @@ class LcdDriver {
          * If the mode is LCD_DATA, the function sets the DC pin to high, sets the CE pin to low, 
          * sends the data, and then sets the CE pin to high.
          * 
+         * Inside a transaction CE stays low, and the DC pin is only written when the mode differs
+         * from the one of the previous write.
+         * 
          * @param data The data to be written to the LCD driver.
          * @param mode The mode of operation (LCD_COMMAND or LCD_DATA).
          */
         void write(uint8_t data, uint8_t mode){
 
-            if (LCD_COMMAND == mode){
+            write(&data, 1, mode);
+        }
 
-                HAL_GPIO_WritePin(pins.DCPORT, pins.DCPIN, GPIO_PIN_RESET);
-                HAL_GPIO_WritePin(pins.CEPORT, pins.CEPIN, GPIO_PIN_RESET);
-                send(data);
-                HAL_GPIO_WritePin(pins.CEPORT, pins.CEPIN, GPIO_PIN_SET);
-            } 
-            
-            else if (LCD_DATA == mode){
+        /**
+         * @brief Writes a run of bytes to the LCD driver under a single chip enable.
+         * 
+         * The DC pin is set according to the mode, the CE pin is pulled low once, all bytes are
+         * handed to the transport in one call, and then the CE pin is set high again.
+         * 
+         * @param data Pointer to the bytes to be written.
+         * @param length The number of bytes to be written.
+         * @param mode The mode of operation (LCD_COMMAND or LCD_DATA).
+         */
+        void write(const uint8_t* data, uint16_t length, uint8_t mode){
+
+            if (LCD_COMMAND != mode && LCD_DATA != mode){
 
-                HAL_GPIO_WritePin(pins.DCPORT, pins.DCPIN, GPIO_PIN_SET);
-                HAL_GPIO_WritePin(pins.CEPORT, pins.CEPIN, GPIO_PIN_RESET);
-                send(data);
-                HAL_GPIO_WritePin(pins.CEPORT, pins.CEPIN, GPIO_PIN_SET);
+                return;
+            }
+            if (streaming){
+
+                /* The stream owns the bus; stop it for the write and restart it from (0, 0). */
+                transport->stop_stream();
+                streaming = false;
+                write(data, length, mode);
+                resume_stream();
+                return;
+            }
+            LCD_TRACE_SCOPE((LCD_DATA == mode) ? "data" : "command", "transport", length);
+            begin_transaction();
+            select_mode(mode);
+            transport->send(data, length);
+            end_transaction();
+            if (LCD_DATA == mode){
+
+                LCD_STATS_ADD(bytes_sent, length);
+            }
+            else {
+
+                LCD_STATS_ADD(commands_sent, length);
             }
         }
-        
+
         /**
-         * @brief Writes data to the screen at the specified position.
+         * @brief Addresses (0, 0) and restarts the stream of stream_source.
+         */
+        void resume_stream(){
+
+            setXY(0, 0);
+            select_mode(LCD_DATA);
+            streaming = transport->start_stream(stream_source, LCD_SIZE);
+        }
+
+        /**
+         * @brief Drives the DC pin for the given mode, skipping the write if it is already set.
          * 
-         * This function writes the specified data to the screen at the given position (x, row).
-         * The affected_rows parameter is a bitmask indicating which rows are affected by the data.
-         * The new_data parameter is a pointer to the data to be written.
-         * The char_width parameter specifies the width of each character in the data.
-         * The bit_count parameter specifies the number of bits in the data.
+         * @param mode The mode of operation (LCD_COMMAND or LCD_DATA).
+         */
+        void select_mode(uint8_t mode){
+
+            if (dc_mode != mode){
+
+                transport->set_line(LcdLine::DC, LCD_DATA == mode);
+                dc_mode = mode;
+            }
+        }
+        
+        /**
+         * @brief Sends the dirty areas of a frame buffer with the cheapest byte stream.
          * 
-         * @param x The x-coordinate of the position to write the data.
-         * @param affected_rows A bitmask indicating which rows are affected by the data.
-         * @param new_data Pointer to the data to be written.
-         * @param char_width The width of each character in the data.
-         * @param bit_count The number of bits in the data.
+         * @param source The frame buffer to read from.
          */
-        void write_to_screen(int x, uint8_t affected_rows, const uint8_t* new_data, int char_width, uint8_t bit_count) {
-            
-            for (int i = 0; i < bit_count; i++) {
-                
-                uint8_t row = 0;
-                for (int j = 7; j > -1; j--) {
+        void flush_planned(const uint8_t* source){
 
-                    if (affected_rows & (1 << j)) {
+            LcdFlushPlanner::Plan plan = LcdFlushPlanner::plan(dirty_first, dirty_last);
+            if (plan.cost == 0){
+
+                return;
+            }
 
-                        row = j;
-                        affected_rows &= ~(1 << j);
-                        break;
+            LCD_STATS_ZONE(flush);
+            LCD_TRACE_SCOPE(plan.vertical ? "planned_vertical" : "planned", "flush", plan.cost);
+            Transaction transaction(*this);
+            if (plan.vertical){
+
+                write(LCD_VERTICAL_FUNCTION_SET, LCD_COMMAND);
+            }
+            LcdFlushPlanner::for_each_run(plan.vertical, dirty_first, dirty_last, [&](uint8_t x, uint8_t bank, uint16_t count, uint8_t address){
+
+                readdress(x, bank, address);
+                if (!plan.vertical){
+
+                    write(&source[(bank * LCD_WIDTH) + x], count, LCD_DATA);
+                    return;
+                }
+                /* Vertical order is not contiguous in the buffer; gather it a few columns at a time. */
+                uint8_t chunk[LCD_BANKS * 8];
+                uint16_t cell = static_cast<uint16_t>((x * LCD_BANKS) + bank);
+                while (count > 0){
+
+                    uint16_t n = count < sizeof(chunk) ? count : static_cast<uint16_t>(sizeof(chunk));
+                    for (uint16_t i = 0; i < n; i++){
+
+                        chunk[i] = source[LcdFlushPlanner::buffer_index(true, static_cast<uint16_t>(cell + i))];
                     }
+                    write(chunk, n, LCD_DATA);
+                    cell = static_cast<uint16_t>(cell + n);
+                    count = static_cast<uint16_t>(count - n);
                 }
+            });
+            if (plan.vertical){
+
+                write(LCD_BASIC_FUNCTION_SET, LCD_COMMAND);
+            }
+            clear_dirty();
+            LCD_STATS_ADD(frames_flushed, 1);
+        }
+
+        /**
+         * @brief Moves the address counter with only the commands the flush plan asks for.
+         * 
+         * @param x The X coordinate of the run.
+         * @param bank The bank of the run.
+         * @param address LcdFlushPlanner::SET_X and LcdFlushPlanner::SET_Y flags.
+         */
+        void readdress(uint8_t x, uint8_t bank, uint8_t address){
+
+            if (address == (LcdFlushPlanner::SET_X | LcdFlushPlanner::SET_Y)){
 
-                setXY(x, row);
-                for (int j = 0; j < char_width; j++) {
+                setXY(x, bank);
+            }
+            else if (address == LcdFlushPlanner::SET_X){
+
+                write(static_cast<uint8_t>(LCD_SETXADDR | x), LCD_COMMAND);
+                _cursor_x = x;
+            }
+            else if (address == LcdFlushPlanner::SET_Y){
+
+                write(static_cast<uint8_t>(LCD_SETYADDR | bank), LCD_COMMAND);
+                _cursor_y = bank;
+            }
+        }
+
+        /**
+         * @brief Starts sending a full frame in the background.
+         * 
+         * Opens the transaction that flush_complete() ends, addresses (0, 0) and hands the frame
+         * to the transport.
+         * 
+         * @param source The frame to send. Must not change until the flush has completed.
+         */
+        void start_flush(const uint8_t* source){
+
+            begin_transaction();
+            setXY(0, 0);
+            select_mode(LCD_DATA);
+            flush_busy = true;
+            flush_source = source;
+            LCD_TRACE_EVENT(LcdTracePhase::AsyncBegin, "async_frame", "transport", LCD_SIZE);
+            transport->send_async(source, LCD_SIZE, &LcdDriver::flush_complete, this);
+        }
+
+        /**
+         * @brief Sends a whole frame with one blocking write.
+         * 
+         * @param source The frame to send.
+         */
+        void write_frame(const uint8_t* source){
+
+            LCD_STATS_ZONE(flush);
+            LCD_TRACE_SCOPE("full_frame", "flush");
+            Transaction transaction(*this);
+            setXY(0, 0);
+            write(source, LCD_SIZE, LCD_DATA);
+            clear_dirty();
+            LCD_STATS_ADD(frames_flushed, 1);
+        }
+
+#if LCD_FRAMEBUFFER_COUNT > 1
+        /**
+         * @brief How present() sends the new front buffer.
+         */
+        enum class Present : uint8_t {
 
-                    write(new_data[j + i * char_width], LCD_DATA);
+            Dirty,      /**< The dirty areas, with blocking writes. */
+            Full,       /**< The whole frame, with one blocking write. */
+            Async       /**< The whole frame, with send_async(). */
+        };
+
+        /**
+         * @brief Turns the back buffer into the front buffer, sends it and picks a new back buffer.
+         * 
+         * Every flush of the buffer goes through here, so the LCD is only ever sent the front buffer.
+         * 
+         * @param mode How the front buffer is sent. A running stream is moved to it instead.
+         */
+        void present(Present mode){
+
+            restore_failed_flush();
+            uint8_t* front = buffer;
+            if (streaming){
+
+                clear_dirty();
+                transport->stop_stream();
+                stream_source = front;
+                resume_stream();
+            }
+            else if (mode == Present::Async){
+
+                clear_dirty();
+                uint32_t primask = enter_critical();
+                if (flush_busy){
+
+                    /* flush_complete() sends it next; an older queued frame is dropped. */
+                    pending_source = front;
+                    exit_critical(primask);
+                }
+                else {
+
+                    exit_critical(primask);
+                    start_flush(front);
+                }
+            }
+            else if (mode == Present::Full){
+
+                write_frame(front);
+            }
+            else {
+
+                flush_planned(front);
+            }
+            buffer = next_back_buffer(front);
+            memcpy(buffer, front, LCD_SIZE);
+        }
+
+        /**
+         * @brief Returns a frame buffer that is neither the front buffer nor being sent.
+         * 
+         * Waits for the running flush when there is no such buffer.
+         * 
+         * @param front The current front buffer.
+         * @return The new back buffer.
+         */
+        uint8_t* next_back_buffer(const uint8_t* front){
+
+            while (true){
+
+                for (uint8_t i = 0; i < LCD_FRAMEBUFFER_COUNT; i++){
+
+                    uint8_t* candidate = frames[i];
+                    if (candidate != front && candidate != flush_source && candidate != pending_source){
+
+                        return candidate;
+                    }
                 }
             }
         }
+#endif
 
+        /**
+         * @brief Disables interrupts and returns the previous interrupt mask.
+         */
+        static uint32_t enter_critical(){
+
+            uint32_t primask = __get_PRIMASK();
+            __disable_irq();
+            return primask;
+        }
+
+        /**
+         * @brief Restores the interrupt mask returned by enter_critical().
+         */
+        static void exit_critical(uint32_t primask){
 
+            __set_PRIMASK(primask);
+        }
 
-        /* Helper function for write_buffer */
         /**
-         * @brief Calculates the shift value based on the font data.
+         * @brief Completion callback of the transfer started by start_flush().
+         * 
+         * If swap() queued another frame meanwhile, it is sent right away: the LCD address
+         * counter wraps to (0, 0) after the last byte, so CE and DC stay as they are. Otherwise
+         * the transaction opened by start_flush() ends and the busy flag is cleared. The user
+         * callback given to refresh_screen_async() is called once.
          * 
-         * This function takes a font data array and determines the appropriate shift value based on the size of the font.
+         * A frame the transport reports as failed is not counted as flushed; the failure is
+         * recorded for restore_failed_flush(), since this may run in interrupt context.
          * 
-         * @tparam T The type of elements in the font data array.
-         * @tparam N The number of columns in the font data array.
-         * @tparam M The number of rows in the font data array.
-         * @param fontData The font data array.
-         * @return The shift value calculated based on the font data.
+         * @param context Pointer to the LcdDriver that started the flush.
          */
-        template <typename T, size_t N, size_t M>
-        int get_shift_value(const std::array<std::array<T, N>, M>& fontData){
+        static void flush_complete(void* context){
 
-            if (arrays_equal(fontData, FontMega) || arrays_equal(fontData, FontHuge)) {
+            LcdDriver* lcd = static_cast<LcdDriver*>(context);
+            LcdTransferCallback callback = lcd->flush_callback;
+            void* callback_context = lcd->flush_context;
+            lcd->flush_callback = nullptr;
+            if (lcd->transport->transfer_failed()){
 
-                return 24;
+                lcd->flush_failed = true;
             }
-            else if (arrays_equal(fontData, FontLarge)) {
+#if LCD_ENABLE_STATS
+            else {
 
-                return 8;
+                lcd->stats_data.frames_flushed++;
+                lcd->stats_data.bytes_sent += LCD_SIZE;
+            }
+#endif
+            LCD_TRACE_EVENT(LcdTracePhase::AsyncEnd, "async_frame", "transport", LCD_SIZE);
+
+            const uint8_t* next = lcd->pending_source;
+            if (next != nullptr){
+
+                lcd->pending_source = nullptr;
+                lcd->flush_source = next;
+                LCD_TRACE_EVENT(LcdTracePhase::AsyncBegin, "async_frame", "transport", LCD_SIZE);
+                lcd->transport->send_async(next, LCD_SIZE, &LcdDriver::flush_complete, lcd);
             }
             else {
 
-                return 0;
+                lcd->flush_source = nullptr;
+                if (--lcd->transaction_depth == 0){
+
+                    lcd->transport->set_line(LcdLine::CE, true);
+                }
+                lcd->flush_busy = false;
+            }
+            if (callback){
+
+                callback(callback_context);
             }
         }
-        
 
+        /**
+         * @brief Marks the whole buffer dirty again after a background flush failed.
+         * 
+         * The panel may hold any part of the failed frame, so the next flush resends all of it.
+         * Called from the flush entry points rather than from flush_complete(), which may
+         * interrupt a draw call that is updating the dirty ranges.
+         */
+        void restore_failed_flush(){
+
+            if (flush_failed){
+
+                flush_failed = false;
+                mark_dirty(0, LCD_SIZE - 1);
+            }
+        }
+
+        /**
+         * @brief Flushes the changes of a draw call when neither a frame nor the manual policy defers it.
+         */
+        void auto_flush(){
+
+            if (frame_depth == 0 && flush_policy == LcdFlushPolicy::PerCall){
+
+                flush();
+            }
+        }
 
-        /* Helper function for font array matching */
         /**
-         * @brief Compares two 2D arrays for equality.
+         * @brief Marks a range of buffer bytes as changed.
          * 
-         * This function compares two 2D arrays of different types and sizes for equality. 
-         * It returns true if the arrays have the same dimensions and all corresponding elements are equal, 
-         * otherwise it returns false.
+         * The range is given as buffer indices and may span several banks; each bank keeps the
+         * smallest column range that covers all of its changes.
          * 
-         * @tparam T The type of elements in the first array.
-         * @tparam N The number of columns in the first array.
-         * @tparam M The number of rows in the first array.
-         * @tparam U The type of elements in the second array.
-         * @tparam P The number of columns in the second array.
-         * @tparam Q The number of rows in the second array.
-         * @param a The first 2D array to compare.
-         * @param b The second 2D array to compare.
-         * @return true if the arrays are equal, false otherwise.
+         * @param first Index of the first changed byte in the buffer.
+         * @param last Index of the last changed byte in the buffer.
          */
-        template <typename T, size_t N, size_t M, typename U, size_t P, size_t Q>
-        bool arrays_equal(const std::array<std::array<T, N>, M>& a, const std::array<std::array<U, P>, Q>& b) {
+        void mark_dirty(uint16_t first, uint16_t last){
 
-            if (M != Q || N != P) {
+            if (last >= LCD_SIZE){
 
-                return false;
+                last = LCD_SIZE - 1;
             }
-            for (size_t i = 0; i < M; ++i) {
+            while (first <= last){
 
-                for (size_t j = 0; j < N; ++j) {
+                uint8_t bank = static_cast<uint8_t>(first / LCD_WIDTH);
+                uint16_t bank_last = static_cast<uint16_t>((bank + 1) * LCD_WIDTH - 1);
+                if (bank_last > last){
 
-                    if (a[i][j] != b[i][j]) {
+                    bank_last = last;
+                }
+                uint8_t x0 = static_cast<uint8_t>(first % LCD_WIDTH);
+                uint8_t x1 = static_cast<uint8_t>(bank_last % LCD_WIDTH);
+                if (x0 < dirty_first[bank]){
 
-                        return false;
-                    }
+                    dirty_first[bank] = x0;
+                }
+                if (x1 > dirty_last[bank]){
+
+                    dirty_last[bank] = x1;
                 }
+                first = static_cast<uint16_t>(bank_last + 1);
             }
-            return true;
         }
 
         /**
-         * @brief Counts the number of set bits in a given 8-bit number.
-         *
-         * This function counts the number of set bits (bits with value 1) in the given 8-bit number.
-         *
-         * @param n The 8-bit number to count the set bits.
-         * @return The number of set bits in the given number.
+         * @brief Marks the whole buffer as being on the screen.
+         */
+        void clear_dirty(){
+
+            memset(dirty_first, LCD_WIDTH, sizeof(dirty_first));
+            memset(dirty_last, 0x00, sizeof(dirty_last));
+        }
+
+        /**
+         * @brief Combines one buffer byte with source bits under a raster op.
+         * 
+         * @param target The buffer byte.
+         * @param source The source bits, already masked.
+         * @param mask The bits of the byte inside the drawn rectangle.
          */
-        uint8_t count_bits(uint8_t n) {
+        template <LcdRasterOp Op>
+        static uint8_t raster(uint8_t target, uint8_t source, uint8_t mask){
+
+            if constexpr (Op == LcdRasterOp::Copy){
 
-            uint8_t bit_count = 0;
-            for (int i = 0; i < 8; i++) {
+                return static_cast<uint8_t>((target & ~mask) | source);
+            }
+            else if constexpr (Op == LcdRasterOp::Or){
 
-                if (n & (1 << i)) {
+                return static_cast<uint8_t>(target | source);
+            }
+            else if constexpr (Op == LcdRasterOp::And){
 
-                    bit_count++;
+                return static_cast<uint8_t>(target & (source | ~mask));
+            }
+            else if constexpr (Op == LcdRasterOp::Xor){
+
+                return static_cast<uint8_t>(target ^ source);
+            }
+            else if constexpr (Op == LcdRasterOp::Not){
+
+                return static_cast<uint8_t>((target & ~mask) | (~source & mask));
+            }
+            else {
+
+                return static_cast<uint8_t>(target & ~source);
+            }
+        }
+
+        /**
+         * @brief Draws a glyph of a font table, from the glyph cache when it is enabled.
+         * 
+         * Picks the loop of the raster op once per glyph.
+         */
+        void draw_glyph(uint8_t x, uint8_t y, const uint8_t* glyph, uint8_t width, uint8_t height, LcdRasterOp op){
+
+            switch (op){
+
+                case LcdRasterOp::Copy: draw_glyph_with<LcdRasterOp::Copy>(x, y, glyph, width, height); break;
+                case LcdRasterOp::Or:   draw_glyph_with<LcdRasterOp::Or>(x, y, glyph, width, height); break;
+                case LcdRasterOp::And:  draw_glyph_with<LcdRasterOp::And>(x, y, glyph, width, height); break;
+                case LcdRasterOp::Xor:  draw_glyph_with<LcdRasterOp::Xor>(x, y, glyph, width, height); break;
+                case LcdRasterOp::Not:  draw_glyph_with<LcdRasterOp::Not>(x, y, glyph, width, height); break;
+                case LcdRasterOp::Clear: draw_glyph_with<LcdRasterOp::Clear>(x, y, glyph, width, height); break;
+            }
+        }
+
+        /**
+         * @brief Draws a glyph with one raster op, from the glyph cache when it is enabled.
+         * 
+         * Only glyphs at a y that is not a multiple of 8 are cached; aligned glyphs need no
+         * shifting and go to blit_with() directly, as do glyphs too large for a cache entry.
+         */
+        template <LcdRasterOp Op>
+        void draw_glyph_with(uint8_t x, uint8_t y, const uint8_t* glyph, uint8_t width, uint8_t height){
+
+#if LCD_GLYPH_CACHE_SIZE > 0
+            const uint8_t shift = y % 8;
+            if (shift != 0 && x < LCD_WIDTH && y < LCD_HEIGHT){
+
+                const auto* entry = glyph_cache.lookup(glyph, width, height, shift);
+                if (entry != nullptr){
+
+                    const uint8_t bank = y / 8;
+                    const uint8_t columns = (width < LCD_WIDTH - x) ? width : static_cast<uint8_t>(LCD_WIDTH - x);
+                    const uint8_t banks = (bank + entry->banks > LCD_BANKS) ? static_cast<uint8_t>(LCD_BANKS - bank) : entry->banks;
+                    const uint64_t mask = ((static_cast<uint64_t>(1) << height) - 1U) << shift;
+                    for (uint8_t b = 0; b < banks; b++){
+
+                        const uint8_t* source = entry->data + b * width;
+                        const uint8_t bank_mask = static_cast<uint8_t>(mask >> (8 * b));
+                        uint8_t* target = buffer + (bank + b) * LCD_WIDTH + x;
+                        for (uint8_t i = 0; i < columns; i++){
+
+                            target[i] = raster<Op>(target[i], source[i], bank_mask);
+                        }
+                        uint16_t first = static_cast<uint16_t>((bank + b) * LCD_WIDTH + x);
+                        mark_dirty(first, static_cast<uint16_t>(first + columns - 1));
+                    }
+                    return;
                 }
             }
-            return bit_count;
+#endif
+            blit_with<Op>(x, y, glyph, width, height);
+        }
+
+        /**
+         * @brief Draws a bank-major bitmap into the buffer at any y with a raster op.
+         * 
+         * Picks the loop of the raster op once per call; see blit_with().
+         */
+        void blit(uint8_t x, uint8_t y, const uint8_t* bitmap, uint8_t width, uint8_t height, LcdRasterOp op){
+
+            switch (op){
+
+                case LcdRasterOp::Copy: blit_with<LcdRasterOp::Copy>(x, y, bitmap, width, height); break;
+                case LcdRasterOp::Or:   blit_with<LcdRasterOp::Or>(x, y, bitmap, width, height); break;
+                case LcdRasterOp::And:  blit_with<LcdRasterOp::And>(x, y, bitmap, width, height); break;
+                case LcdRasterOp::Xor:  blit_with<LcdRasterOp::Xor>(x, y, bitmap, width, height); break;
+                case LcdRasterOp::Not:  blit_with<LcdRasterOp::Not>(x, y, bitmap, width, height); break;
+                case LcdRasterOp::Clear: blit_with<LcdRasterOp::Clear>(x, y, bitmap, width, height); break;
+            }
         }
 
-        /* Helper function for write_buffer */
         /**
-         * @brief Finds the affected rows on an LCD display based on the given y-coordinate and character height.
+         * @brief Draws a bank-major bitmap into the buffer at any y with one raster op.
          * 
-         * This function calculates the rows that will be affected on an LCD display based on the given y-coordinate and character height.
-         * It returns a uint8_t value representing the affected rows.
+         * The bitmap is drawn in strips of up to 24 rows. For each column, the strip's bank bytes are
+         * loaded into one 32-bit word, shifted to y % 8 and masked to the bitmap height once, and the
+         * word is merged into the (up to four) buffer bytes it covers with raster<Op>(). No scratch
+         * buffer is needed. The touched columns are marked dirty; whatever is outside the screen is
+         * clipped.
          * 
-         * @param y The y-coordinate of the starting position.
-         * @param char_height The height of the character.
-         * @return The affected rows as a uint8_t value.
+         * @tparam Op How the bitmap is combined with the buffer.
+         * @param x The x-coordinate of the top-left corner.
+         * @param y The y-coordinate of the top-left corner.
+         * @param bitmap The bitmap data, width bytes per 8 pixel bank, top bank first.
+         * @param width The width of the bitmap in pixels.
+         * @param height The height of the bitmap in pixels.
          */
-        uint8_t find_affected_rows(uint8_t y, uint8_t char_height){
+        template <LcdRasterOp Op>
+        void blit_with(uint8_t x, uint8_t y, const uint8_t* bitmap, uint8_t width, uint8_t height){
+
+            if (x >= LCD_WIDTH || y >= LCD_HEIGHT || width == 0 || height == 0){
+
+                return;
+            }
+            const uint8_t columns = (width < LCD_WIDTH - x) ? width : static_cast<uint8_t>(LCD_WIDTH - x);
+            const uint8_t shift = y % 8;
+
+            for (uint8_t row = 0; row < height; row = static_cast<uint8_t>(row + 24)){
+
+                const uint8_t bank = static_cast<uint8_t>(y / 8 + row / 8);
+                if (bank >= LCD_BANKS){
+
+                    break;
+                }
+                const uint8_t rows = (height - row < 24) ? static_cast<uint8_t>(height - row) : 24;
+                const uint8_t source_banks = static_cast<uint8_t>((rows + 7) / 8);
+                uint8_t target_banks = static_cast<uint8_t>((shift + rows + 7) / 8);
+                if (bank + target_banks > LCD_BANKS){
 
-            volatile uint8_t affected_rows = 0;
-            for ( int i = 0; i < LCD_HEIGHT; i+=8 ){
+                    target_banks = static_cast<uint8_t>(LCD_BANKS - bank);
+                }
+                const uint32_t mask = ((1U << rows) - 1U) << shift;
+                const uint8_t* source = bitmap + (row / 8) * width;
+                uint8_t* target = buffer + bank * LCD_WIDTH + x;
+
+                for (uint8_t i = 0; i < columns; i++){
+
+                    uint32_t word = 0;
+                    for (uint8_t b = 0; b < source_banks; b++){
 
-                if ( y < i + 8 && y >= i){
+                        word |= static_cast<uint32_t>(source[b * width + i]) << (8 * b);
+                    }
+                    word = (word << shift) & mask;
+                    for (uint8_t b = 0; b < target_banks; b++){
 
-                    affected_rows |= 1 << (i/8); // start row
+                        uint8_t& byte = target[b * LCD_WIDTH + i];
+                        byte = raster<Op>(byte, static_cast<uint8_t>(word >> (8 * b)), static_cast<uint8_t>(mask >> (8 * b)));
+                    }
                 }
-                if ( (y + char_height - 1) < i + 8 && (y + char_height ) >= i){
+                for (uint8_t b = 0; b < target_banks; b++){
 
-                    affected_rows |= 1 << (i/8); // end row
+                    uint16_t first = static_cast<uint16_t>((bank + b) * LCD_WIDTH + x);
+                    mark_dirty(first, static_cast<uint16_t>(first + columns - 1));
                 }
             }
-            // set the bits between start and end row
-            for ( int i = (y/8) + 1; i < (y + char_height - 1)/8; i++){
+        }
+
+        /**
+         * @brief Clips a solid rectangle to the screen and draws it with a raster op.
+         *
+         * Picks the loop of the raster op once per call; see rect_with().
+         */
+        void rect(int x, int y, int width, int height, LcdRasterOp op){
+
+            if (x < 0){
 
-                affected_rows |= 1 << i;
+                width += x;
+                x = 0;
+            }
+            if (y < 0){
+
+                height += y;
+                y = 0;
+            }
+            if (width > LCD_WIDTH - x){
+
+                width = LCD_WIDTH - x;
+            }
+            if (height > LCD_HEIGHT - y){
+
+                height = LCD_HEIGHT - y;
+            }
+            if (width <= 0 || height <= 0){
+
+                return;
+            }
+
+            const uint8_t cx = static_cast<uint8_t>(x);
+            const uint8_t cy = static_cast<uint8_t>(y);
+            const uint8_t cw = static_cast<uint8_t>(width);
+            const uint8_t ch = static_cast<uint8_t>(height);
+            switch (op){
+
+                case LcdRasterOp::Copy: rect_with<LcdRasterOp::Copy>(cx, cy, cw, ch); break;
+                case LcdRasterOp::Or:   rect_with<LcdRasterOp::Or>(cx, cy, cw, ch); break;
+                case LcdRasterOp::And:  break;      // a solid source keeps every pixel
+                case LcdRasterOp::Xor:  rect_with<LcdRasterOp::Xor>(cx, cy, cw, ch); break;
+                case LcdRasterOp::Not:
+                case LcdRasterOp::Clear: rect_with<LcdRasterOp::Not>(cx, cy, cw, ch); break;   // the same for a solid source
             }
-            return affected_rows;
         }
 
+        /**
+         * @brief Draws a solid rectangle, already clipped to the screen, with one raster op.
+         *
+         * The mask of the top and of the bottom bank is computed once and applied with raster<Op>()
+         * to every column; the banks in between are set or cleared with memset, or inverted byte
+         * by byte for Xor. Each touched bank is marked dirty once.
+         */
+        template <LcdRasterOp Op>
+        void rect_with(uint8_t x, uint8_t y, uint8_t width, uint8_t height){
 
-        struct Pins{
+            const uint8_t top = y / 8;
+            const uint8_t bottom = static_cast<uint8_t>((y + height - 1) / 8);
+            const uint8_t top_mask = static_cast<uint8_t>(0xFF << (y % 8));
+            const uint8_t bottom_mask = static_cast<uint8_t>(0xFF >> (7 - (y + height - 1) % 8));
+
+            for (uint8_t bank = top; bank <= bottom; bank++){
+
+                uint8_t mask = 0xFF;
+                if (bank == top){
+
+                    mask &= top_mask;
+                }
+                if (bank == bottom){
+
+                    mask &= bottom_mask;
+                }
+
+                uint8_t* target = buffer + bank * LCD_WIDTH + x;
+                if (mask == 0xFF && Op != LcdRasterOp::Xor){
+
+                    memset(target, (Op == LcdRasterOp::Not) ? 0x00 : 0xFF, width);
+                }
+                else {
+
+                    for (uint8_t i = 0; i < width; i++){
+
+                        target[i] = raster<Op>(target[i], mask, mask);
+                    }
+                }
+                uint16_t first = static_cast<uint16_t>(bank * LCD_WIDTH + x);
+                mark_dirty(first, static_cast<uint16_t>(first + width - 1));
+            }
+        }
 
-            GPIO_TypeDef* RSTPORT;
-            GPIO_TypeDef* CEPORT;
-            GPIO_TypeDef* DCPORT;
-            GPIO_TypeDef* DINPORT;
-            GPIO_TypeDef* CLKPORT;
-            uint16_t RSTPIN;
-            uint16_t CEPIN;
-            uint16_t DCPIN;
-            uint16_t DINPIN;
-            uint16_t CLKPIN;
-        };
 
-        Pins pins;
+        LcdGpioTransport gpio_transport;
+        LcdTransport* transport;
 
         uint8_t LCD_COMMAND{0};
         uint8_t LCD_DATA{1};
+        static const uint8_t LCD_MODE_UNKNOWN{0xFF};
+        uint8_t dc_mode{LCD_MODE_UNKNOWN};
+        uint8_t transaction_depth{0};
 
         static const uint16_t LCD_WIDTH{84};
         static const uint16_t LCD_HEIGHT{48};
         static const uint16_t LCD_SIZE{LCD_WIDTH * LCD_HEIGHT / 8};
-        uint8_t buffer[LCD_SIZE]{0x00};
+        static const uint8_t LCD_BANKS{LCD_HEIGHT / 8};
+        uint8_t frames[LCD_FRAMEBUFFER_COUNT][LCD_SIZE]{};
+        /* Back buffer: the one draw calls write to. */
+        uint8_t* buffer{frames[0]};
+        /* Column range changed per bank since the last refresh; first > last means clean. */
+        uint8_t dirty_first[LCD_BANKS]{LCD_WIDTH, LCD_WIDTH, LCD_WIDTH, LCD_WIDTH, LCD_WIDTH, LCD_WIDTH};
+        uint8_t dirty_last[LCD_BANKS]{0x00};
+#if LCD_FRAMEBUFFER_COUNT == 1
+        uint8_t flush_buffer[LCD_SIZE]{0x00};
+#endif
+        volatile bool flush_busy{false};
+        /* Set by flush_complete() when the transport reports a failed transfer. */
+        volatile bool flush_failed{false};
+        /* Frame being sent by start_flush() and the frame queued behind it by swap(). */
+        const uint8_t* volatile flush_source{nullptr};
+        const uint8_t* volatile pending_source{nullptr};
+        /* Buffer mirrored by start_streaming(). */
+        const uint8_t* stream_source{nullptr};
+        bool streaming{false};
+        LcdTransferCallback flush_callback{nullptr};
+        void* flush_context{nullptr};
+#if LCD_ENABLE_STATS
+        LcdStats stats_data{};
+#endif
+#if LCD_GLYPH_CACHE_SIZE > 0
+        LcdGlyphCache<LCD_GLYPH_CACHE_SIZE, LCD_GLYPH_CACHE_ENTRY_BYTES> glyph_cache;
+#endif
+        LcdFlushPolicy flush_policy{LcdFlushPolicy::PerCall};
+        uint8_t frame_depth{0};
         int _cursor_x{0};
         int _cursor_y{0};
-        bool inverttext{false};
+        LcdRasterOp default_op{LcdRasterOp::Or};
 
 
+        uint8_t LCD_BASIC_FUNCTION_SET{0x20};
+        uint8_t LCD_VERTICAL_FUNCTION_SET{0x22};
         uint8_t LCD_SETYADDR{0x40};
         uint8_t LCD_SETXADDR{0x80};
         uint8_t LCD_DISPLAY_BLANK{0x08};
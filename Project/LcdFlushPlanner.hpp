@@ -0,0 +1,205 @@
+
+/**
+ * @file LcdFlushPlanner.hpp
+ * @brief This file contains the flush planner used by LcdDriver::refresh_dirty().
+ *
+ * A partial flush has to address every dirty span of the display RAM. A re-address only sends
+ * the coordinates that differ from where the address counter stands after the previous span:
+ * one command byte (set X or set Y) when the bank or the column stays the same, two otherwise.
+ * For gaps not longer than that it is cheaper to send the clean bytes in between instead. The PCD8544 also offers a vertical addressing mode (V=1 in the function set
+ * command) where the address counter walks down the 6 banks of a column before moving to the
+ * next column. Tall, narrow updates are contiguous in that order and need a single address.
+ *
+ * The planner computes the byte cost of a dirty set in both addressing modes, bridging every
+ * gap that is not more expensive to send than to re-address, and picks the cheaper mode. Either
+ * choice leaves the counter at the next dirty cell, so deciding each gap on its own gives the
+ * cheapest stream for the mode.
+ *
+ * @author Ömer Gökyer
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+/**
+ * @brief Plans the cheapest byte stream for a set of dirty column ranges.
+ *
+ * The dirty set is described per bank by a column range first[bank]..last[bank]; a bank is
+ * clean when first > last. Cells are numbered in the order the LCD address counter visits
+ * them: bank * 84 + x in horizontal mode and x * 6 + bank in vertical mode. A run is a range
+ * of consecutive cell numbers sent after one setXY.
+ */
+class LcdFlushPlanner {
+
+    public:
+
+        static const uint8_t WIDTH{84};
+        static const uint8_t BANKS{6};
+        static const uint16_t CELLS{WIDTH * BANKS};
+
+        /** Re-address flag: the run needs a set X command. */
+        static const uint8_t SET_X{0x01};
+        /** Re-address flag: the run needs a set Y command. */
+        static const uint8_t SET_Y{0x02};
+        /** Bytes to enter and leave vertical addressing (two function set commands). */
+        static const uint8_t VERTICAL_MODE_COST{2};
+
+        /**
+         * @brief Result of planning a flush.
+         */
+        struct Plan {
+
+            bool vertical;      /**< True if vertical addressing is cheaper. */
+            uint16_t cost;      /**< Total bytes (commands and data) of the chosen plan. */
+        };
+
+        /**
+         * @brief Chooses the addressing mode with the cheapest byte stream.
+         *
+         * @param first First dirty column of each bank.
+         * @param last Last dirty column of each bank.
+         * @return The chosen mode and its cost. The cost is 0 if nothing is dirty.
+         */
+        static Plan plan(const uint8_t* first, const uint8_t* last){
+
+            uint16_t horizontal = cost(false, first, last);
+            uint16_t vertical = cost(true, first, last);
+            if (vertical < horizontal){
+
+                return Plan{true, vertical};
+            }
+            return Plan{false, horizontal};
+        }
+
+        /**
+         * @brief Computes the bytes needed to flush the dirty set in one addressing mode.
+         *
+         * @param vertical True for vertical addressing, false for horizontal addressing.
+         * @param first First dirty column of each bank.
+         * @param last Last dirty column of each bank.
+         * @return Command plus data bytes, or 0 if nothing is dirty.
+         */
+        static uint16_t cost(bool vertical, const uint8_t* first, const uint8_t* last){
+
+            uint16_t total = 0;
+            for_each_run(vertical, first, last, [&total](uint8_t, uint8_t, uint16_t count, uint8_t address){
+
+                total = static_cast<uint16_t>(total + address_cost(address) + count);
+            });
+            if (vertical && total > 0){
+
+                total = static_cast<uint16_t>(total + VERTICAL_MODE_COST);
+            }
+            return total;
+        }
+
+        /**
+         * @brief Calls emit(x, bank, count, address) for every run of the optimal plan in one mode.
+         *
+         * Dirty cells are visited in address counter order. A gap of clean cells is bridged
+         * (its bytes are sent along) when it is not longer than the re-address from the cell
+         * after the run, otherwise the current run ends and a new one starts at the next dirty
+         * cell. The first run is always addressed with both commands, since the counter position
+         * before the flush is not known.
+         *
+         * @param vertical True for vertical addressing, false for horizontal addressing.
+         * @param first First dirty column of each bank.
+         * @param last Last dirty column of each bank.
+         * @param emit Callable taking (uint8_t x, uint8_t bank, uint16_t count, uint8_t address) of a
+         *             run start; address holds the SET_X and SET_Y commands the run needs.
+         */
+        template <typename Emit>
+        static void for_each_run(bool vertical, const uint8_t* first, const uint8_t* last, Emit&& emit){
+
+            int run_start = -1;
+            int run_end = -1;
+            uint8_t address = SET_X | SET_Y;
+            for (int cell = 0; cell < CELLS; cell++){
+
+                uint8_t x = vertical ? static_cast<uint8_t>(cell / BANKS) : static_cast<uint8_t>(cell % WIDTH);
+                uint8_t bank = vertical ? static_cast<uint8_t>(cell % BANKS) : static_cast<uint8_t>(cell / WIDTH);
+                if (x < first[bank] || x > last[bank]){
+
+                    continue;
+                }
+                if (run_start >= 0){
+
+                    uint8_t jump = readdress(vertical, static_cast<uint16_t>((run_end + 1) % CELLS), static_cast<uint16_t>(cell));
+                    if (cell - run_end - 1 > address_cost(jump)){
+
+                        emit_run(vertical, run_start, run_end, address, emit);
+                        run_start = -1;
+                        address = jump;
+                    }
+                }
+                if (run_start < 0){
+
+                    run_start = cell;
+                }
+                run_end = cell;
+            }
+            if (run_start >= 0){
+
+                emit_run(vertical, run_start, run_end, address, emit);
+            }
+        }
+
+        /**
+         * @brief Returns the commands that move the address counter from one cell to another.
+         *
+         * @param vertical True if the cells are numbered in vertical addressing order.
+         * @param from The cell the counter points to.
+         * @param to The cell to address.
+         * @return SET_X if the column differs, SET_Y if the bank differs, 0 for the same cell.
+         */
+        static uint8_t readdress(bool vertical, uint16_t from, uint16_t to){
+
+            uint8_t address = 0;
+            if (vertical ? (from / BANKS != to / BANKS) : (from % WIDTH != to % WIDTH)){
+
+                address |= SET_X;
+            }
+            if (vertical ? (from % BANKS != to % BANKS) : (from / WIDTH != to / WIDTH)){
+
+                address |= SET_Y;
+            }
+            return address;
+        }
+
+        /**
+         * @brief Returns the command bytes of a re-address.
+         *
+         * @param address SET_X and SET_Y flags.
+         */
+        static uint8_t address_cost(uint8_t address){
+
+            return static_cast<uint8_t>(((address & SET_X) ? 1 : 0) + ((address & SET_Y) ? 1 : 0));
+        }
+
+        /**
+         * @brief Converts a cell number to its index in the bank-major frame buffer.
+         *
+         * @param vertical True if the cell is numbered in vertical addressing order.
+         * @param cell The cell number.
+         * @return Index of the cell in the buffer (bank * 84 + x).
+         */
+        static uint16_t buffer_index(bool vertical, uint16_t cell){
+
+            if (vertical){
+
+                return static_cast<uint16_t>((cell % BANKS) * WIDTH + cell / BANKS);
+            }
+            return cell;
+        }
+
+    private:
+
+        template <typename Emit>
+        static void emit_run(bool vertical, int start, int end, uint8_t address, Emit& emit){
+
+            uint8_t x = vertical ? static_cast<uint8_t>(start / BANKS) : static_cast<uint8_t>(start % WIDTH);
+            uint8_t bank = vertical ? static_cast<uint8_t>(start % BANKS) : static_cast<uint8_t>(start / WIDTH);
+            emit(x, bank, static_cast<uint16_t>(end - start + 1), address);
+        }
+};
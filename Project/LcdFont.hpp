@@ -0,0 +1,141 @@
+/**
+ * @file LcdFont.hpp
+ * @brief This file contains the font descriptor taken by the text functions of LcdDriver.
+ *
+ * A font is a table of glyphs plus its geometry. LcdFont carries the geometry as compile-time
+ * constants, so print() and print_buffer() know the glyph size and the character range of a
+ * font from its type instead of comparing the table with the known fonts at run time.
+ *
+ * Glyphs are drawn from bank-major bytes, the layout of the display RAM. lcd_font_banks()
+ * converts a table of column words to that layout at compile time.
+ *
+ * @author Ömer Gökyer
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <array>
+
+/**
+ * @brief How the glyphs of a font are stored.
+ */
+enum class LcdFontFormat : uint8_t {
+
+    Columns,    /**< One word of type T per column, the top pixel in the least significant bit. */
+    Banks       /**< Width bytes per 8 pixel bank, top bank first, the top pixel of a bank in bit 0. */
+};
+
+/**
+ * @brief Describes a font: its glyph table, glyph size, character range and storage format.
+ *
+ * @tparam T Type of one glyph column in the Columns format: uint8_t for 8 pixel high fonts,
+ *           uint16_t or uint32_t for taller ones. Always uint8_t in the Banks format.
+ * @tparam Width Glyph width in pixels.
+ * @tparam Count Number of glyphs in the table.
+ * @tparam First Character of the first glyph; the others follow in ASCII order.
+ * @tparam Height Glyph height in pixels, the bits of T by default.
+ * @tparam Format Storage format of the glyph table.
+ *
+ * @usage
+ * static const std::array<std::array<uint8_t, 5>, 10> DigitsData = {{ ... }};
+ * static constexpr LcdFont<uint8_t, 5, 10, '0'> Digits{DigitsData};
+ * lcd.print_buffer("42", 0, 0, Digits);
+ */
+template <typename T, size_t Width, size_t Count, char First, uint8_t Height = 8 * sizeof(T),
+          LcdFontFormat Format = LcdFontFormat::Columns>
+struct LcdFont {
+
+    static constexpr uint8_t width = Width;
+    static constexpr uint8_t height = Height;
+    static constexpr uint8_t banks = (Height + 7) / 8;   /**< Display banks one glyph spans at y % 8 == 0. */
+
+    using column_type = T;
+    using glyph_type = std::array<T, (Format == LcdFontFormat::Banks) ? Width * banks : Width>;
+
+    static constexpr char first = First;
+    static constexpr char last = static_cast<char>(First + Count - 1);
+    static constexpr LcdFontFormat format = Format;
+
+    static_assert(Width > 0 && Count > 0, "a font needs at least one glyph column and one glyph");
+    static_assert(Format == LcdFontFormat::Banks || (Height > 0 && Height <= 8 * sizeof(T)),
+                  "the glyph height must fit the column type");
+    static_assert(Format == LcdFontFormat::Columns || sizeof(T) == 1, "bank-major glyphs are bytes");
+
+    const std::array<glyph_type, Count>& glyphs;    /**< The glyph table. */
+
+    /** Blank glyph drawn for characters the font does not have. */
+    static constexpr glyph_type blank{};
+
+    /**
+     * @brief Tells whether the font has a glyph for a character.
+     */
+    static constexpr bool contains(char c){
+
+        return c >= first && c <= last;
+    }
+
+    /**
+     * @brief Returns the glyph of a character, or a blank glyph if the font does not have it.
+     */
+    constexpr const glyph_type& glyph(char c) const {
+
+        return contains(c) ? glyphs[static_cast<size_t>(c - first)] : blank;
+    }
+
+    /**
+     * @brief Returns the glyph of a character as bank-major bytes: bank b of column i is at
+     *        [b * width + i].
+     *
+     * Fonts of one byte per column are bank-major already; taller column fonts have to be
+     * converted with lcd_font_banks() first.
+     */
+    constexpr const uint8_t* glyph_bytes(char c) const {
+
+        static_assert(Format == LcdFontFormat::Banks || sizeof(T) == 1,
+                      "convert the font to bank-major bytes with lcd_font_banks()");
+        return glyph(c).data();
+    }
+};
+
+/**
+ * @brief Font of bank-major byte glyphs, the format the renderer copies from.
+ */
+template <size_t Width, size_t Count, char First, uint8_t Height>
+using LcdBankFont = LcdFont<uint8_t, Width, Count, First, Height, LcdFontFormat::Banks>;
+
+/**
+ * @brief Converts a table of column words to bank-major byte glyphs.
+ *
+ * Meant for constant initialization, so the conversion runs in the compiler and only the byte
+ * table ends up in flash. Only ceil(Height / 8) bytes of each column are kept, which drops the
+ * unused top byte of fonts lower than their column type.
+ *
+ * @tparam Height Glyph height in pixels.
+ * @param columns The glyph table in the Columns format.
+ * @return The glyph table in the Banks format.
+ *
+ * @usage
+ * static constexpr auto FontHugeBanks = lcd_font_banks<24>(FontHugeData);
+ * static constexpr LcdBankFont<16, 13, '.', 24> FontHuge{FontHugeBanks};
+ */
+template <uint8_t Height, typename T, size_t Width, size_t Count>
+constexpr std::array<std::array<uint8_t, Width * ((Height + 7) / 8)>, Count>
+lcd_font_banks(const std::array<std::array<T, Width>, Count>& columns){
+
+    static_assert(Height > 0 && Height <= 8 * sizeof(T), "the glyph height must fit the column type");
+    constexpr size_t banks = (Height + 7) / 8;
+    std::array<std::array<uint8_t, Width * banks>, Count> glyphs{};
+    for (size_t g = 0; g < Count; g++){
+
+        for (size_t bank = 0; bank < banks; bank++){
+
+            for (size_t i = 0; i < Width; i++){
+
+                glyphs[g][bank * Width + i] = static_cast<uint8_t>(columns[g][i] >> (8 * bank));
+            }
+        }
+    }
+    return glyphs;
+}
@@ -0,0 +1,185 @@
+/**
+ * @file LcdGlyphCache.hpp
+ * @brief This file contains the pre-shifted glyph cache of the LcdDriver class.
+ *
+ * Text drawn at a y that is not a multiple of 8 has to be shifted across two or more banks.
+ * Menus and status lines draw the same glyphs at the same y % 8 every frame, so with
+ * LCD_GLYPH_CACHE_SIZE set above 0 the driver keeps the shifted bank bytes of the most recently
+ * used glyphs and ORs them into the buffer on the next use. With the default of 0 the cache is
+ * compiled out.
+ *
+ * @author Ömer Gökyer
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+/**
+ * Number of shifted glyphs kept by the cache, 0 to compile it out. Every entry takes
+ * LCD_GLYPH_CACHE_ENTRY_BYTES plus 12 bytes of RAM (16 on a 64-bit host).
+ */
+#ifndef LCD_GLYPH_CACHE_SIZE
+#define LCD_GLYPH_CACHE_SIZE 0
+#endif
+
+/**
+ * Bytes of shifted data per cache entry. A glyph of width w and height h needs
+ * w * ((h + 7) / 8 + 1) bytes; larger glyphs are drawn without the cache. The default fits
+ * every 8 pixel font of font.h and FontLarge.
+ */
+#ifndef LCD_GLYPH_CACHE_ENTRY_BYTES
+#define LCD_GLYPH_CACHE_ENTRY_BYTES 36
+#endif
+
+/**
+ * @brief Hit and miss counters of the glyph cache, polled with LcdDriver::glyph_cache_stats().
+ */
+struct LcdGlyphCacheStats {
+
+    uint32_t hits;      /**< Glyphs drawn from the cache. */
+    uint32_t misses;    /**< Glyphs shifted and stored, evicting the least recently used entry. */
+};
+
+/**
+ * @brief Fixed-size LRU cache of glyphs shifted to a y % 8.
+ *
+ * Entries are keyed by the address of the glyph bytes and the shift, so the glyphs must not
+ * change while cached; the driver only caches the constant tables of font descriptors.
+ *
+ * @tparam Entries Number of entries.
+ * @tparam EntryBytes Bytes of shifted data per entry.
+ */
+template <size_t Entries, size_t EntryBytes>
+class LcdGlyphCache {
+
+    public:
+
+        /**
+         * @brief One shifted glyph: banks rows of width bytes, top bank first.
+         */
+        struct Entry {
+
+            const uint8_t* glyph;
+            uint32_t last_use;
+            uint8_t shift;
+            uint8_t width;
+            uint8_t height;
+            uint8_t banks;
+            uint8_t data[EntryBytes];
+        };
+
+        /**
+         * @brief Returns the glyph shifted down by shift pixels, from the cache or newly shifted.
+         *
+         * @param glyph Bank-major glyph bytes: width bytes per 8 pixel bank.
+         * @param width Glyph width in pixels.
+         * @param height Glyph height in pixels.
+         * @param shift Pixels to shift down, 1 to 7.
+         * @return The entry, or nullptr if the shifted glyph does not fit an entry.
+         */
+        const Entry* lookup(const uint8_t* glyph, uint8_t width, uint8_t height, uint8_t shift){
+
+            const uint8_t banks = static_cast<uint8_t>((height + shift + 7) / 8);
+            if (static_cast<size_t>(width) * banks > EntryBytes){
+
+                return nullptr;
+            }
+
+            if (++use_clock == 0){
+
+                restart_clock();
+            }
+            Entry* victim = &entries[0];
+            for (Entry& entry : entries){
+
+                if (entry.glyph == glyph && entry.shift == shift && entry.width == width && entry.height == height){
+
+                    entry.last_use = use_clock;
+                    counters.hits++;
+                    return &entry;
+                }
+                if (entry.last_use < victim->last_use){
+
+                    victim = &entry;
+                }
+            }
+
+            counters.misses++;
+            fill(*victim, glyph, width, height, shift, banks);
+            return victim;
+        }
+
+        /**
+         * @brief Drops every entry and zeroes the counters.
+         */
+        void clear(){
+
+            for (Entry& entry : entries){
+
+                entry.glyph = nullptr;
+                entry.last_use = 0;
+            }
+            use_clock = 0;
+            counters = LcdGlyphCacheStats{};
+        }
+
+        const LcdGlyphCacheStats& stats() const {
+
+            return counters;
+        }
+
+    private:
+
+        /**
+         * @brief Keeps the LRU order working when the use counter wraps: every entry becomes
+         *        equally old.
+         */
+        void restart_clock(){
+
+            for (Entry& entry : entries){
+
+                entry.last_use = 0;
+            }
+            use_clock = 1;
+        }
+
+        /**
+         * @brief Shifts a glyph into an entry, one bank byte at a time with the carry of the bank above.
+         */
+        void fill(Entry& entry, const uint8_t* glyph, uint8_t width, uint8_t height, uint8_t shift, uint8_t banks){
+
+            entry.glyph = glyph;
+            entry.last_use = use_clock;
+            entry.shift = shift;
+            entry.width = width;
+            entry.height = height;
+            entry.banks = banks;
+
+            const uint8_t source_banks = static_cast<uint8_t>((height + 7) / 8);
+            const uint8_t last_mask = static_cast<uint8_t>(0xFF >> (8 * source_banks - height));
+            for (uint8_t i = 0; i < width; i++){
+
+                uint8_t carry = 0;
+                for (uint8_t b = 0; b < banks; b++){
+
+                    uint8_t bits = 0;
+                    if (b < source_banks){
+
+                        bits = glyph[b * width + i];
+                        if (b == source_banks - 1){
+
+                            bits &= last_mask;
+                        }
+                    }
+                    entry.data[b * width + i] = static_cast<uint8_t>((bits << shift) | carry);
+                    carry = static_cast<uint8_t>(bits >> (8 - shift));
+                }
+            }
+        }
+
+        Entry entries[Entries]{};
+        uint32_t use_clock{0};
+        LcdGlyphCacheStats counters{};
+};
@@ -0,0 +1,20 @@
+
+/**
+ * @file LcdHal.hpp
+ * @brief This file selects the hardware layer the LCD driver is compiled against.
+ *
+ * On the target this is the STM32 HAL. With LCD_HOST_BUILD defined (set by the host target in
+ * Host/CMakeLists.txt) it is a small stand-in that provides the same GPIO types and functions
+ * but records every pin change instead of driving hardware, so the driver and the rendering
+ * code can be built and tested on a PC.
+ *
+ * @author Ömer Gökyer
+ */
+
+#pragma once
+
+#ifdef LCD_HOST_BUILD
+#include "lcd_host_hal.h"
+#else
+#include "stm32f4xx_hal.h"
+#endif
@@ -0,0 +1,14 @@
+/**
+ * @file LcdSpiTransport.cpp
+ * @brief This file connects the HAL SPI completion callback in Core/Src/spi.c to LcdSpiTransport.
+ *
+ * @author Ömer Gökyer
+ */
+
+#include "spi.h"
+#include <Project/LcdSpiTransport.hpp>
+
+extern "C" void lcd_spi_tx_complete(SPI_HandleTypeDef* hspi){
+
+    LcdSpiTransport::tx_complete(hspi);
+}
@@ -0,0 +1,290 @@
+
+/**
+ * @file LcdSpiTransport.hpp
+ * @brief This file contains the hardware SPI transport for the LcdDriver class.
+ *
+ * LcdSpiTransport shifts the LCD byte stream out through an STM32 SPI peripheral instead of
+ * toggling DIN/CLK from the CPU. RST, CE and DC are still plain GPIO outputs and are assigned
+ * with set_pin() exactly like the bit-banged transport.
+ *
+ * The reference wiring uses SPI2 (see Core/Src/spi.c): SCK on PB13 and MOSI on PB15.
+ * When the SPI handle has a TX DMA stream linked (hspi2 uses DMA1 Stream4), send_async()
+ * returns immediately and the transfer completes in the background, and start_stream() can
+ * mirror a frame buffer to the panel continuously. HAL_SPI_TxCpltCallback() in Core/Src/spi.c
+ * forwards the HAL completion event to tx_complete() through lcd_spi_tx_complete(); a
+ * project that also drives other SPI devices adds their handling there.
+ *
+ * @author Ömer Gökyer
+ */
+
+#pragma once
+
+#include "LcdTransport.hpp"
+
+/**
+ * @brief Transport that sends LCD data through HAL_SPI.
+ *
+ * The SPI peripheral must be configured as a transmit capable master, 8-bit frames,
+ * MSB first, CPOL low and CPHA on the first edge, with a clock of at most 4 MHz.
+ *
+ * @usage
+ * LcdSpiTransport spi(&hspi2);
+ * LcdDriver lcd(spi);
+ * lcd.set_pin(GPIOB, GPIO_PIN_14, LcdLine::RST);
+ */
+class LcdSpiTransport : public LcdGpioTransport {
+
+    public:
+
+        /**
+         * @brief Creates a transport bound to an initialized SPI handle.
+         *
+         * @param handle The SPI handle, for example &hspi2 from Core/Src/spi.c.
+         */
+        explicit LcdSpiTransport(SPI_HandleTypeDef* handle) : hspi(handle) {
+
+            next = first;
+            first = this;
+        }
+
+        /**
+         * @brief Stops a running stream and unlinks the transport from the list tx_complete() walks.
+         *
+         * The list is changed with interrupts disabled, so a completion interrupt never sees a
+         * transport that is going away. A single DMA transfer must have completed before.
+         */
+        ~LcdSpiTransport(){
+
+            stop_stream();
+            uint32_t primask = __get_PRIMASK();
+            __disable_irq();
+            for (LcdSpiTransport** link = &first; *link != nullptr; link = &(*link)->next){
+
+                if (*link == this){
+
+                    *link = next;
+                    break;
+                }
+            }
+            __set_PRIMASK(primask);
+        }
+
+        LcdSpiTransport(const LcdSpiTransport&) = delete;
+        LcdSpiTransport& operator=(const LcdSpiTransport&) = delete;
+
+        /**
+         * @brief Sends bytes to the LCD with a single blocking SPI transfer.
+         *
+         * @param data Pointer to the bytes to send.
+         * @param length The number of bytes to send.
+         */
+        void send(const uint8_t* data, uint16_t length) override {
+
+            HAL_SPI_Transmit(hspi, const_cast<uint8_t*>(data), length, HAL_MAX_DELAY);
+        }
+
+        /**
+         * @brief Starts a DMA transfer of the given bytes and returns immediately.
+         *
+         * If the SPI handle has no TX DMA stream, or the DMA transfer cannot be started, the
+         * bytes are sent with a blocking transfer instead and the callback is called directly.
+         *
+         * @param data Pointer to the bytes to send. Must stay valid until done is called.
+         * @param length The number of bytes to send.
+         * @param done Function called from the DMA interrupt once the transfer is complete.
+         * @param context Pointer passed back to the done callback.
+         */
+        void send_async(const uint8_t* data, uint16_t length, LcdTransferCallback done, void* context) override {
+
+            if (hspi->hdmatx != nullptr){
+
+                done_callback = done;
+                done_context = context;
+                in_flight = true;
+                if (HAL_SPI_Transmit_DMA(hspi, const_cast<uint8_t*>(data), length) == HAL_OK){
+
+                    return;
+                }
+                in_flight = false;
+            }
+            LcdTransport::send_async(data, length, done, context);
+        }
+
+        /**
+         * @brief Tells whether a DMA transfer is still in flight.
+         *
+         * @return True until tx_complete() has been called for the running transfer.
+         */
+        bool busy() const override {
+
+            return in_flight;
+        }
+
+        /**
+         * @brief Tells whether send_async() uses DMA.
+         * 
+         * @return True if the SPI handle has a TX DMA stream linked.
+         */
+        bool async_capable() const override {
+
+            return hspi->hdmatx != nullptr;
+        }
+
+        /**
+         * @brief Streams the given bytes continuously with the TX DMA stream in circular mode.
+         * 
+         * The DMA stream is switched to circular mode for as long as the stream runs. Each pass
+         * calls HAL_SPI_TxCpltCallback(); tx_complete() ignores those calls.
+         * 
+         * @param data Pointer to the bytes to send. Must stay valid until stop_stream().
+         * @param length The number of bytes of one pass.
+         * @return True if streaming has started, false without a TX DMA stream.
+         */
+        bool start_stream(const uint8_t* data, uint16_t length) override {
+
+            if (hspi->hdmatx == nullptr){
+
+                return false;
+            }
+            set_dma_mode(DMA_CIRCULAR);
+            const uint32_t transfer_prescaler = READ_BIT(hspi->Instance->CR1, SPI_CR1_BR);
+            if (stream_limited){
+
+                set_prescaler(stream_prescaler);
+            }
+            if (HAL_SPI_Transmit_DMA(hspi, const_cast<uint8_t*>(data), length) != HAL_OK){
+
+                set_prescaler(transfer_prescaler);
+                set_dma_mode(DMA_NORMAL);
+                return false;
+            }
+            saved_prescaler = transfer_prescaler;
+            streaming = true;
+            return true;
+        }
+
+        /**
+         * @brief Stops the circular stream and waits until the SPI is idle.
+         * 
+         * Blocking and single transfers run at the SPI clock they had before the stream again.
+         */
+        void stop_stream() override {
+
+            if (!streaming){
+
+                return;
+            }
+            HAL_SPI_DMAStop(hspi);
+            while (!__HAL_SPI_GET_FLAG(hspi, SPI_FLAG_TXE) || __HAL_SPI_GET_FLAG(hspi, SPI_FLAG_BSY)){
+            }
+            set_dma_mode(DMA_NORMAL);
+            set_prescaler(saved_prescaler);
+            streaming = false;
+        }
+
+        /**
+         * @brief Lowers the SPI clock of the following streams to bound their pass rate.
+         * 
+         * The prescaler is the smallest one that keeps both the pass rate and the 4 MHz PCD8544
+         * clock limit. A circular stream has no idle time between passes, so the SPI clock is the
+         * only knob for its refresh rate. The prescaler is applied by start_stream() and the
+         * previous one is restored by stop_stream(); other transfers keep their clock.
+         * 
+         * With SPI2 on a 42 MHz APB1 the slowest clock (prescaler 256) still gives about 40 passes
+         * per second for a 504 byte frame, about 80 on SPI1. A lower max_rate cannot be met and
+         * leaves the stream clock unchanged.
+         * 
+         * @param max_rate The highest pass rate in Hz.
+         * @param frame_bytes The number of bytes of one pass.
+         * @return True if the pass rate is bounded by max_rate, false if no prescaler is slow enough.
+         * 
+         * @usage
+         * if (!spi.limit_stream_rate(60, 504)){
+         *     // stream at full speed, or draw with flush() instead
+         * }
+         */
+        bool limit_stream_rate(uint32_t max_rate, uint16_t frame_bytes){
+
+            const uint32_t max_clock = 4000000U;
+            uint32_t pclk = (hspi->Instance == SPI1) ? HAL_RCC_GetPCLK2Freq() : HAL_RCC_GetPCLK1Freq();
+            uint32_t bits = static_cast<uint32_t>(frame_bytes) * 8U;
+            uint32_t shift = 1;
+            while (shift < 8 && ((pclk >> shift) > max_clock || (pclk >> shift) / bits > max_rate)){
+
+                shift++;
+            }
+            if ((pclk >> shift) > max_clock || (pclk >> shift) / bits > max_rate){
+
+                return false;
+            }
+
+            stream_prescaler = (shift - 1) << SPI_CR1_BR_Pos;
+            stream_limited = true;
+            return true;
+        }
+
+        /**
+         * @brief Forwards the HAL SPI transmit complete event to the owning transport.
+         *
+         * Called from HAL_SPI_TxCpltCallback() in Core/Src/spi.c. The HAL only reports completion after the
+         * SPI has stopped clocking, so CE can be released from the done callback.
+         *
+         * @param handle The SPI handle passed to HAL_SPI_TxCpltCallback().
+         */
+        static void tx_complete(SPI_HandleTypeDef* handle){
+
+            for (LcdSpiTransport* t = first; t != nullptr; t = t->next){
+
+                if (t->hspi == handle && t->in_flight){
+
+                    t->in_flight = false;
+                    if (t->done_callback){
+
+                        t->done_callback(t->done_context);
+                    }
+                }
+            }
+        }
+
+    private:
+
+        /**
+         * @brief Switches the TX DMA stream between normal and circular mode.
+         * 
+         * @param mode DMA_NORMAL or DMA_CIRCULAR.
+         */
+        void set_dma_mode(uint32_t mode){
+
+            if (hspi->hdmatx->Init.Mode != mode){
+
+                hspi->hdmatx->Init.Mode = mode;
+                HAL_DMA_Init(hspi->hdmatx);
+            }
+        }
+
+        /**
+         * @brief Changes the SPI clock prescaler; the SPI is disabled until the next transfer enables it.
+         * 
+         * @param prescaler The SPI_CR1_BR bits.
+         */
+        void set_prescaler(uint32_t prescaler){
+
+            if (READ_BIT(hspi->Instance->CR1, SPI_CR1_BR) != prescaler){
+
+                __HAL_SPI_DISABLE(hspi);
+                MODIFY_REG(hspi->Instance->CR1, SPI_CR1_BR, prescaler);
+            }
+        }
+
+        SPI_HandleTypeDef* hspi;
+        volatile bool in_flight{false};
+        bool streaming{false};
+        bool stream_limited{false};
+        uint32_t stream_prescaler{0};
+        uint32_t saved_prescaler{0};
+        LcdTransferCallback done_callback{nullptr};
+        void* done_context{nullptr};
+
+        LcdSpiTransport* next{nullptr};
+        static inline LcdSpiTransport* first{nullptr};
+};
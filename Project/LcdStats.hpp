@@ -0,0 +1,118 @@
+/**
+ * @file LcdStats.hpp
+ * @brief This file contains the profiling zones and statistics of the LcdDriver class.
+ *
+ * With LCD_ENABLE_STATS set to 1 the driver times its flushes, glyph rendering and clears with
+ * the DWT cycle counter and counts the frames and bytes it sends. The figures are read with
+ * LcdDriver::stats(). With the default of 0 the instrumentation is compiled out: no counters in
+ * the driver, no cycle counter reads and no code on the draw and flush paths.
+ *
+ * @author Ömer Gökyer
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#include "LcdHal.hpp"
+
+/**
+ * Set to 1 to compile the profiling zones and counters into LcdDriver.
+ */
+#ifndef LCD_ENABLE_STATS
+#define LCD_ENABLE_STATS 0
+#endif
+
+/**
+ * @brief Cycle statistics of one kind of work.
+ */
+struct LcdZoneStats {
+
+    uint32_t count;             /**< Times the zone was entered. */
+    uint32_t last_cycles;       /**< Cycles of the most recent run. */
+    uint32_t worst_cycles;      /**< Cycles of the slowest run. */
+    uint64_t total_cycles;      /**< Cycles of all runs together. */
+
+    /**
+     * @brief Returns the average cycles per run, 0 before the first run.
+     */
+    uint32_t average_cycles() const {
+
+        return (count == 0) ? 0 : static_cast<uint32_t>(total_cycles / count);
+    }
+
+    /**
+     * @brief Records one run of the zone.
+     */
+    void add(uint32_t cycles){
+
+        count++;
+        last_cycles = cycles;
+        if (cycles > worst_cycles){
+
+            worst_cycles = cycles;
+        }
+        total_cycles += cycles;
+    }
+};
+
+/**
+ * @brief Running statistics of an LcdDriver, polled with LcdDriver::stats().
+ *
+ * The flush zone covers the blocking flushes (refresh_screen(), refresh_dirty(), flush() and the
+ * direct write of clear()). A background flush counts as a frame, and its bytes as sent, when it
+ * completes; only the CPU time to start it is spent inside the driver, so it has no zone. The
+ * counters are updated without locking, also from the DMA completion interrupt: they are meant
+ * for telemetry, not for exact accounting.
+ */
+struct LcdStats {
+
+    uint32_t frames_flushed;    /**< Frames sent, by a blocking or a background flush. */
+    uint32_t bytes_sent;        /**< Display data bytes sent. */
+    uint32_t commands_sent;     /**< Command bytes sent. */
+    LcdZoneStats flush;         /**< Sending frames or dirty areas to the LCD. */
+    LcdZoneStats render;        /**< One run per glyph of print_buffer(), print() and put_char_xy(), per fill_rect() and invert_rect(). */
+    LcdZoneStats clear;         /**< clear(), clear_area() and clear_rect() on the buffer. */
+};
+
+/**
+ * @brief Starts the DWT cycle counter used by the profiling zones.
+ */
+inline void lcd_stats_start_cycle_counter(){
+
+    SET_BIT(CoreDebug->DEMCR, CoreDebug_DEMCR_TRCENA_Msk);
+    SET_BIT(DWT->CTRL, DWT_CTRL_CYCCNTENA_Msk);
+}
+
+/**
+ * @brief RAII guard that adds the cycles of its lifetime to a zone.
+ */
+class LcdProfileZone {
+
+    public:
+
+        explicit LcdProfileZone(LcdZoneStats& stats) : zone(stats), start(DWT->CYCCNT) {}
+
+        ~LcdProfileZone(){
+
+            zone.add(static_cast<uint32_t>(DWT->CYCCNT) - start);
+        }
+
+        LcdProfileZone(const LcdProfileZone&) = delete;
+        LcdProfileZone& operator=(const LcdProfileZone&) = delete;
+
+    private:
+
+        LcdZoneStats& zone;
+        uint32_t start;
+};
+
+#if LCD_ENABLE_STATS
+/** Times the rest of the enclosing scope into the given zone of LcdStats. */
+#define LCD_STATS_ZONE(name)        LcdProfileZone lcd_stats_zone_##name(stats_data.name)
+/** Adds n to a counter of LcdStats. */
+#define LCD_STATS_ADD(counter, n)   (stats_data.counter += (n))
+#else
+#define LCD_STATS_ZONE(name)
+#define LCD_STATS_ADD(counter, n)   static_cast<void>(0)
+#endif
@@ -0,0 +1,298 @@
+
+/**
+ * @file LcdTimerDmaTransport.hpp
+ * @brief This file contains the timer paced DMA bit-bang transport for the LcdDriver class.
+ *
+ * When DIN and CLK are on pins without SPI or USART functions, the serial waveform can still be
+ * produced without the CPU: every bit becomes two words for the GPIO BSRR register (DIN with CLK
+ * low, then CLK high) and a DMA stream triggered by a timer update event writes them out at a
+ * fixed rate. Bytes are expanded chunk by chunk into a small ping-pong buffer from the DMA half
+ * and full transfer interrupts, so the RAM used does not grow with the transfer length.
+ *
+ * Only DMA2 can write to the GPIO ports of the STM32F4, so the timer has to be one whose update
+ * event is routed to DMA2: TIM1 (DMA2 Stream5 Channel 6) or TIM8 (DMA2 Stream1 Channel 7). The
+ * DMA stream interrupt has to be forwarded to the HAL:
+ *
+ * @code
+ * extern "C" void DMA2_Stream5_IRQHandler(void){
+ *     HAL_DMA_IRQHandler(&hdma_tim1_up);
+ * }
+ * @endcode
+ *
+ * @author Ömer Gökyer
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#include "LcdTransport.hpp"
+
+/**
+ * @brief Transport that bit-bangs DIN/CLK with timer triggered DMA writes to GPIOx->BSRR.
+ *
+ * DIN and CLK may be any two pins of the same GPIO port, since one DMA stream writes one BSRR
+ * register. RST, CE and DC are assigned with set_pin() like on LcdGpioTransport. If DIN and CLK
+ * are on different ports the transport falls back to the CPU driven send() of LcdGpioTransport,
+ * and async_capable() returns false so the driver does not expect background transfers.
+ *
+ * The DMA handle must be initialized for memory to peripheral transfers of words with memory
+ * increment, in circular mode, and the timer clock must be enabled.
+ *
+ * @usage
+ * __HAL_RCC_TIM1_CLK_ENABLE();
+ * LcdTimerDmaTransport bus(TIM1, &hdma_tim1_up);
+ * LcdDriver lcd(bus);
+ * lcd.set_pin(GPIOE, GPIO_PIN_2, LcdLine::DIN);
+ * lcd.set_pin(GPIOE, GPIO_PIN_4, LcdLine::CLK);
+ * bus.configure(1000000);
+ */
+class LcdTimerDmaTransport : public LcdGpioTransport {
+
+    public:
+
+        /**
+         * @brief Creates a transport bound to a timer and the DMA stream of its update event.
+         *
+         * @param instance The timer, TIM1 or TIM8.
+         * @param hdma The initialized DMA handle of the timer update request.
+         */
+        LcdTimerDmaTransport(TIM_TypeDef* instance, DMA_HandleTypeDef* hdma) : timer(instance), hdmatx(hdma) {
+
+            hdmatx->Parent = this;
+            hdmatx->XferHalfCpltCallback = &LcdTimerDmaTransport::half_complete;
+            hdmatx->XferCpltCallback = &LcdTimerDmaTransport::full_complete;
+            hdmatx->XferErrorCallback = &LcdTimerDmaTransport::transfer_error;
+            hdmatx->XferAbortCallback = &LcdTimerDmaTransport::aborted;
+        }
+
+        LcdTimerDmaTransport(const LcdTimerDmaTransport&) = delete;
+        LcdTimerDmaTransport& operator=(const LcdTimerDmaTransport&) = delete;
+
+        /**
+         * @brief Sets the timer up to produce the given CLK frequency.
+         *
+         * Every CLK period takes two timer updates. DMA2 needs a few bus cycles per word, so
+         * stay well below 4 MHz; 1 MHz leaves room for other DMA2 traffic.
+         *
+         * TIM1 and TIM8 sit on APB2 and run at PCLK2 when the APB2 prescaler is 1, at twice
+         * PCLK2 otherwise.
+         *
+         * @param clock_hz The CLK frequency.
+         */
+        void configure(uint32_t clock_hz){
+
+            RCC_ClkInitTypeDef clocks{};
+            uint32_t latency = 0;
+            HAL_RCC_GetClockConfig(&clocks, &latency);
+            uint32_t tclk = HAL_RCC_GetPCLK2Freq();
+            if (clocks.APB2CLKDivider != RCC_HCLK_DIV1){
+
+                tclk *= 2;
+            }
+            timer->CR1 = 0;
+            timer->DIER = 0;
+            timer->PSC = 0;
+            timer->ARR = tclk / (2 * clock_hz) - 1;
+            timer->EGR = TIM_EGR_UG;
+        }
+
+        /**
+         * @brief Sends bytes to the LCD and waits until they have been clocked out.
+         *
+         * The waveform is still produced by the DMA; the CPU only expands the chunks.
+         *
+         * @param data Pointer to the bytes to send.
+         * @param length The number of bytes to send.
+         */
+        void send(const uint8_t* data, uint16_t length) override {
+
+            send_async(data, length, nullptr, nullptr);
+            while (in_flight){
+            }
+        }
+
+        /**
+         * @brief Starts producing the waveform of the given bytes and returns immediately.
+         *
+         * @param data Pointer to the bytes to send. Must stay valid until done is called.
+         * @param length The number of bytes to send.
+         * @param done Function called from the DMA interrupt once the last CLK edge is out.
+         * @param context Pointer passed back to the done callback.
+         */
+        void send_async(const uint8_t* data, uint16_t length, LcdTransferCallback done, void* context) override {
+
+            if (length == 0 || pins.DINPORT != pins.CLKPORT){
+
+                LcdGpioTransport::send(data, length);
+                if (done){
+
+                    done(context);
+                }
+                return;
+            }
+
+            source = data;
+            remaining = length;
+            halves_left = static_cast<uint16_t>((length + CHUNK_BYTES - 1) / CHUNK_BYTES);
+            bit_words[0] = static_cast<uint32_t>(pins.DINPIN) << 16 | static_cast<uint32_t>(pins.CLKPIN) << 16;
+            bit_words[1] = pins.DINPIN | static_cast<uint32_t>(pins.CLKPIN) << 16;
+            fill(0);
+            fill(1);
+
+            done_callback = done;
+            done_context = context;
+            in_flight = true;
+            uint32_t wave_address = static_cast<uint32_t>(reinterpret_cast<uintptr_t>(wave));
+            uint32_t bsrr_address = static_cast<uint32_t>(reinterpret_cast<uintptr_t>(&pins.CLKPORT->BSRR));
+            if (HAL_DMA_Start_IT(hdmatx, wave_address, bsrr_address, 2 * HALF_WORDS) != HAL_OK){
+
+                in_flight = false;
+                LcdGpioTransport::send(data, length);
+                if (done){
+
+                    done(context);
+                }
+                return;
+            }
+            timer->CNT = 0;
+            SET_BIT(timer->DIER, TIM_DIER_UDE);
+            SET_BIT(timer->CR1, TIM_CR1_CEN);
+        }
+
+        /**
+         * @brief Tells whether a transfer is still in flight.
+         *
+         * @return True until the last CLK edge of the running transfer is out.
+         */
+        bool busy() const override {
+
+            return in_flight;
+        }
+
+        /**
+         * @brief Tells whether send_async() runs in the background.
+         *
+         * @return True if DIN and CLK share a GPIO port.
+         */
+        bool async_capable() const override {
+
+            return pins.DINPORT != nullptr && pins.DINPORT == pins.CLKPORT;
+        }
+
+        /** Bytes expanded per half of the ping-pong buffer. */
+        static const uint16_t CHUNK_BYTES{8};
+
+    private:
+
+        /** BSRR words per half: two per bit. */
+        static const uint16_t HALF_WORDS{CHUNK_BYTES * 16};
+
+        /**
+         * @brief Expands the next chunk of bytes into one half of the waveform buffer.
+         *
+         * Words past the last byte only keep CLK high, so the tail of the last half is idle.
+         *
+         * @param half 0 for the first half, 1 for the second half.
+         */
+        void fill(uint8_t half){
+
+            uint32_t* words = &wave[half * HALF_WORDS];
+            uint32_t idle = pins.CLKPIN;
+            for (uint16_t n = 0; n < CHUNK_BYTES; n++){
+
+                if (remaining == 0){
+
+                    for (uint8_t bit = 0; bit < 16; bit++){
+
+                        *words++ = idle;
+                    }
+                    continue;
+                }
+                uint8_t byte = *source++;
+                remaining--;
+                for (int bit = 7; bit >= 0; bit--){
+
+                    *words++ = bit_words[(byte >> bit) & 0x01];
+                    *words++ = idle;
+                }
+            }
+        }
+
+        /**
+         * @brief Handles the end of one half: stops after the last data half, else refills it.
+         *
+         * @param half The half the DMA has just finished.
+         */
+        void half_done(uint8_t half){
+
+            if (--halves_left == 0){
+
+                finish();
+                return;
+            }
+            fill(half);
+        }
+
+        /**
+         * @brief Stops the timer and the DMA stream; completion is reported once the stream is off.
+         *
+         * Runs in the DMA interrupt, so the stream is stopped with HAL_DMA_Abort_IT(), which does
+         * not wait: the HAL calls aborted() from the next stream interrupt. After a transfer error
+         * the HAL has stopped the stream already and completion is reported right away.
+         */
+        void finish(){
+
+            CLEAR_BIT(timer->CR1, TIM_CR1_CEN);
+            CLEAR_BIT(timer->DIER, TIM_DIER_UDE);
+            if (HAL_DMA_Abort_IT(hdmatx) != HAL_OK){
+
+                complete();
+            }
+        }
+
+        /**
+         * @brief Ends the transfer and calls the done callback.
+         */
+        void complete(){
+
+            in_flight = false;
+            if (done_callback){
+
+                done_callback(done_context);
+            }
+        }
+
+        static void half_complete(DMA_HandleTypeDef* hdma){
+
+            static_cast<LcdTimerDmaTransport*>(hdma->Parent)->half_done(0);
+        }
+
+        static void full_complete(DMA_HandleTypeDef* hdma){
+
+            static_cast<LcdTimerDmaTransport*>(hdma->Parent)->half_done(1);
+        }
+
+        static void transfer_error(DMA_HandleTypeDef* hdma){
+
+            static_cast<LcdTimerDmaTransport*>(hdma->Parent)->finish();
+        }
+
+        static void aborted(DMA_HandleTypeDef* hdma){
+
+            static_cast<LcdTimerDmaTransport*>(hdma->Parent)->complete();
+        }
+
+        TIM_TypeDef* timer;
+        DMA_HandleTypeDef* hdmatx;
+        volatile bool in_flight{false};
+        LcdTransferCallback done_callback{nullptr};
+        void* done_context{nullptr};
+
+        const uint8_t* source{nullptr};
+        uint16_t remaining{0};
+        uint16_t halves_left{0};
+        /* BSRR word of the first half bit period: DIN reset or set, together with CLK low. */
+        uint32_t bit_words[2]{};
+        uint32_t wave[2 * HALF_WORDS]{};
+};
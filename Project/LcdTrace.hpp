@@ -0,0 +1,114 @@
+/**
+ * @file LcdTrace.hpp
+ * @brief This file contains the event trace hooks of the LcdDriver class.
+ *
+ * With LCD_ENABLE_TRACE set to 1 the driver reports the begin and end of its public calls, of
+ * every flush and of every transport burst to an LcdTraceSink, which can lay them out on a
+ * timeline (see LcdChromeTracer in the host build). With the default of 0 the hooks compile out.
+ *
+ * Three kinds of public calls have no event of their own: the overloads without a raster op,
+ * which forward to the traced overload; the const accessors (is_dirty(), is_flushing(),
+ * is_streaming(), stats(), glyph_cache_stats(), raster_op()), which only read a member; and
+ * put_char(), which is commented out in LcdDriver.hpp.
+ *
+ * @author Ömer Gökyer
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+/**
+ * Set to 1 to compile the trace hooks into LcdDriver.
+ */
+#ifndef LCD_ENABLE_TRACE
+#define LCD_ENABLE_TRACE 0
+#endif
+
+/**
+ * @brief Kind of a trace event.
+ */
+enum class LcdTracePhase : uint8_t {
+
+    Begin,          /**< A call or burst starts. Ends in the same call stack. */
+    End,            /**< The matching end of Begin. */
+    AsyncBegin,     /**< A background transfer starts. */
+    AsyncEnd        /**< The background transfer completes, possibly in an interrupt. */
+};
+
+/**
+ * @brief Receives the trace events of the driver.
+ */
+class LcdTraceSink {
+
+    public:
+
+        /**
+         * @brief Called for every event.
+         *
+         * @param phase Kind of the event.
+         * @param name Name of the call or burst, a string literal.
+         * @param category "api", "flush" or "transport", a string literal.
+         * @param bytes Bytes moved by a burst, 0 otherwise.
+         */
+        virtual void trace(LcdTracePhase phase, const char* name, const char* category, uint32_t bytes) = 0;
+
+    protected:
+
+        ~LcdTraceSink() = default;
+};
+
+/** The sink receiving the events, nullptr while nobody listens. */
+inline LcdTraceSink* lcd_trace_sink{nullptr};
+
+/**
+ * @brief Sends one event to the sink, if there is one.
+ */
+inline void lcd_trace(LcdTracePhase phase, const char* name, const char* category, uint32_t bytes = 0){
+
+    if (lcd_trace_sink != nullptr){
+
+        lcd_trace_sink->trace(phase, name, category, bytes);
+    }
+}
+
+/**
+ * @brief RAII guard that reports Begin on construction and End on destruction.
+ */
+class LcdTraceScope {
+
+    public:
+
+        LcdTraceScope(const char* event_name, const char* event_category, uint32_t event_bytes = 0)
+            : name(event_name), category(event_category), bytes(event_bytes) {
+
+            lcd_trace(LcdTracePhase::Begin, name, category, bytes);
+        }
+
+        ~LcdTraceScope(){
+
+            lcd_trace(LcdTracePhase::End, name, category, bytes);
+        }
+
+        LcdTraceScope(const LcdTraceScope&) = delete;
+        LcdTraceScope& operator=(const LcdTraceScope&) = delete;
+
+    private:
+
+        const char* name;
+        const char* category;
+        uint32_t bytes;
+};
+
+#define LCD_TRACE_CONCAT_(a, b)     a##b
+#define LCD_TRACE_CONCAT(a, b)      LCD_TRACE_CONCAT_(a, b)
+
+#if LCD_ENABLE_TRACE
+/** Traces the rest of the enclosing scope: LCD_TRACE_SCOPE(name, category[, bytes]). */
+#define LCD_TRACE_SCOPE(...)        LcdTraceScope LCD_TRACE_CONCAT(lcd_trace_scope_, __LINE__)(__VA_ARGS__)
+/** Reports a single event: LCD_TRACE_EVENT(phase, name, category[, bytes]). */
+#define LCD_TRACE_EVENT(...)        lcd_trace(__VA_ARGS__)
+#else
+#define LCD_TRACE_SCOPE(...)
+#define LCD_TRACE_EVENT(...)        static_cast<void>(0)
+#endif
@@ -0,0 +1,272 @@
+
+/**
+ * @file LcdTransport.hpp
+ * @brief This file contains the transport interface used by the LcdDriver class.
+ *
+ * A transport is the layer between the LcdDriver and the PCD8544 controller. It drives
+ * the RST, CE and DC control lines and shifts command/data bytes out to the display.
+ * LcdGpioTransport is the default backend and bit-bangs DIN/CLK with HAL_GPIO_WritePin.
+ * Hardware backends (see LcdSpiTransport.hpp) implement the same interface and are
+ * handed to the LcdDriver constructor.
+ *
+ * @author Ömer Gökyer
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#include "LcdHal.hpp"
+
+/**
+ * @brief Signal lines of the PCD8544 serial interface.
+ */
+enum class LcdLine : uint8_t {
+
+    RST,
+    CE,
+    DC,
+    DIN,
+    CLK
+};
+
+/**
+ * @brief Completion callback of an asynchronous transfer.
+ *
+ * The callback may run in interrupt context.
+ */
+typedef void (*LcdTransferCallback)(void* context);
+
+/**
+ * @brief Reverses the bit order of a byte.
+ *
+ * Used by transports whose hardware sends the least significant bit first.
+ *
+ * @param n The byte to reverse.
+ * @return The byte with bit 7 and bit 0, bit 6 and bit 1, and so on swapped.
+ */
+constexpr uint8_t lcd_reverse_bits(uint8_t n){
+
+    n = static_cast<uint8_t>((n & 0xF0) >> 4 | (n & 0x0F) << 4);
+    n = static_cast<uint8_t>((n & 0xCC) >> 2 | (n & 0x33) << 2);
+    n = static_cast<uint8_t>((n & 0xAA) >> 1 | (n & 0x55) << 1);
+    return n;
+}
+
+/**
+ * @brief Interface for the byte transport between LcdDriver and the LCD.
+ *
+ * Implementations only need to know how to set a control line and how to shift a run of
+ * bytes out MSB first. Chip enable and data/command selection are driven by the LcdDriver
+ * through set_line(), so a backend never has to interpret the byte stream.
+ */
+class LcdTransport {
+
+    public:
+
+        /**
+         * @brief Assigns a GPIO pin to one of the LCD signal lines.
+         *
+         * Backends that do not use GPIO pins for the given line simply ignore the call.
+         *
+         * @param PORT The GPIO port to which the pin belongs.
+         * @param PIN The pin number.
+         * @param line The signal line driven by the pin.
+         */
+        virtual void set_pin(GPIO_TypeDef* PORT, uint16_t PIN, LcdLine line){}
+
+        /**
+         * @brief Drives one of the RST, CE or DC control lines.
+         *
+         * @param line The control line to drive.
+         * @param level True for a high level, false for a low level.
+         */
+        virtual void set_line(LcdLine line, bool level) = 0;
+
+        /**
+         * @brief Shifts a run of bytes out to the LCD, MSB first.
+         *
+         * The function returns when the last bit has been clocked out, so the caller may
+         * release CE right after it.
+         *
+         * @param data Pointer to the bytes to send.
+         * @param length The number of bytes to send.
+         */
+        virtual void send(const uint8_t* data, uint16_t length) = 0;
+
+        /**
+         * @brief Starts shifting a run of bytes out to the LCD without waiting for it.
+         *
+         * The data must stay valid until the done callback has been called. Backends without
+         * DMA support fall back to a blocking send() followed by the callback, so the callback
+         * may also run before this function returns.
+         *
+         * @param data Pointer to the bytes to send.
+         * @param length The number of bytes to send.
+         * @param done Function called once the last bit has been clocked out. May be nullptr.
+         * @param context Pointer passed back to the done callback.
+         */
+        virtual void send_async(const uint8_t* data, uint16_t length, LcdTransferCallback done, void* context){
+
+            send(data, length);
+            if (done){
+
+                done(context);
+            }
+        }
+
+        /**
+         * @brief Tells whether an asynchronous transfer is still in flight.
+         *
+         * @return True while a transfer started with send_async() has not completed.
+         */
+        virtual bool busy() const {
+
+            return false;
+        }
+
+        /**
+         * @brief Tells whether send_async() returns before the transfer has completed.
+         * 
+         * LcdDriver::swap() sends full frames in the background on such transports and only
+         * the changed areas, with blocking writes, on all others.
+         * 
+         * @return True if send_async() runs in the background.
+         */
+        virtual bool async_capable() const {
+
+            return false;
+        }
+
+        /**
+         * @brief Tells whether the last transfer started with send_async() failed.
+         * 
+         * Read by the done callback of that transfer. A failed transfer still calls its done
+         * callback, so the caller can release the bus, and may have left the LCD with any part of
+         * the data.
+         * 
+         * @return True if the transfer ended with an error.
+         */
+        virtual bool transfer_failed() const {
+
+            return false;
+        }
+
+        /**
+         * @brief Starts sending a run of bytes over and over without CPU involvement.
+         * 
+         * The bytes are read from memory on every pass, so changes to them show up on the next
+         * pass. Backends without circular DMA return false and send nothing.
+         * 
+         * @param data Pointer to the bytes to send. Must stay valid until stop_stream().
+         * @param length The number of bytes of one pass.
+         * @return True if streaming has started.
+         */
+        virtual bool start_stream(const uint8_t* data, uint16_t length){
+
+            return false;
+        }
+
+        /**
+         * @brief Stops a stream started with start_stream().
+         * 
+         * Returns once the last byte has been clocked out. The stream may stop in the middle of
+         * a pass.
+         */
+        virtual void stop_stream(){}
+
+    protected:
+
+        ~LcdTransport() = default;
+};
+
+/**
+ * @brief Bit-banged transport using HAL_GPIO_WritePin on arbitrary pins.
+ *
+ * This is the transport the LcdDriver uses when no other backend is given. Every pin can be
+ * placed on any GPIO port; the pins are assigned at runtime with set_pin().
+ */
+class LcdGpioTransport : public LcdTransport {
+
+    public:
+
+        /**
+         * @brief Assigns a GPIO pin to one of the LCD signal lines.
+         *
+         * @param PORT The GPIO port to which the pin belongs.
+         * @param PIN The pin number.
+         * @param line The signal line driven by the pin.
+         */
+        void set_pin(GPIO_TypeDef* PORT, uint16_t PIN, LcdLine line) override {
+
+            switch (line){
+
+                case LcdLine::RST: pins.RSTPORT = PORT; pins.RSTPIN = PIN; break;
+                case LcdLine::CE:  pins.CEPORT  = PORT; pins.CEPIN  = PIN; break;
+                case LcdLine::DC:  pins.DCPORT  = PORT; pins.DCPIN  = PIN; break;
+                case LcdLine::DIN: pins.DINPORT = PORT; pins.DINPIN = PIN; break;
+                case LcdLine::CLK: pins.CLKPORT = PORT; pins.CLKPIN = PIN; break;
+            }
+        }
+
+        /**
+         * @brief Drives one of the RST, CE or DC control lines.
+         *
+         * @param line The control line to drive.
+         * @param level True for a high level, false for a low level.
+         */
+        void set_line(LcdLine line, bool level) override {
+
+            GPIO_PinState state = level ? GPIO_PIN_SET : GPIO_PIN_RESET;
+            switch (line){
+
+                case LcdLine::RST: HAL_GPIO_WritePin(pins.RSTPORT, pins.RSTPIN, state); break;
+                case LcdLine::CE:  HAL_GPIO_WritePin(pins.CEPORT, pins.CEPIN, state); break;
+                case LcdLine::DC:  HAL_GPIO_WritePin(pins.DCPORT, pins.DCPIN, state); break;
+                case LcdLine::DIN: HAL_GPIO_WritePin(pins.DINPORT, pins.DINPIN, state); break;
+                case LcdLine::CLK: HAL_GPIO_WritePin(pins.CLKPORT, pins.CLKPIN, state); break;
+            }
+        }
+
+        /**
+         * @brief Sends bytes to the LCD by toggling the DIN and CLK pins.
+         *
+         * Each byte is written bit by bit, starting from the most significant bit (MSB) to the
+         * least significant bit (LSB). The display samples DIN on the rising edge of CLK.
+         *
+         * @param data Pointer to the bytes to send.
+         * @param length The number of bytes to send.
+         */
+        void send(const uint8_t* data, uint16_t length) override {
+
+            for (uint16_t n = 0; n < length; n++){
+
+                uint8_t byte = data[n];
+                for (int i = 0; i < 8; i++){
+
+                    HAL_GPIO_WritePin(pins.DINPORT, pins.DINPIN, (byte & 0x80) ? GPIO_PIN_SET : GPIO_PIN_RESET);
+                    HAL_GPIO_WritePin(pins.CLKPORT, pins.CLKPIN, GPIO_PIN_RESET);
+                    HAL_GPIO_WritePin(pins.CLKPORT, pins.CLKPIN, GPIO_PIN_SET);
+                    byte = static_cast<uint8_t>(byte << 1);
+                }
+            }
+        }
+
+    protected:
+
+        struct Pins{
+
+            GPIO_TypeDef* RSTPORT;
+            GPIO_TypeDef* CEPORT;
+            GPIO_TypeDef* DCPORT;
+            GPIO_TypeDef* DINPORT;
+            GPIO_TypeDef* CLKPORT;
+            uint16_t RSTPIN;
+            uint16_t CEPIN;
+            uint16_t DCPIN;
+            uint16_t DINPIN;
+            uint16_t CLKPIN;
+        };
+
+        Pins pins{};
+};
@@ -0,0 +1,285 @@
+
+/**
+ * @file LcdUsartTransport.hpp
+ * @brief This file contains the USART synchronous mode transport for the LcdDriver class.
+ *
+ * On boards where DIN and CLK are wired to USART TX and CK pins instead of SPI pins, the USART
+ * can still clock the byte stream out in synchronous mode. A USART sends the least significant
+ * bit first while the PCD8544 expects the most significant bit first, so every byte is bit
+ * reversed before it is sent: through a 256 entry table built from lcd_reverse_bits(), or four
+ * bytes at a time with the Cortex-M4 RBIT and REV instructions for DMA transfers.
+ *
+ * The HAL USART driver is not part of this project, so the USART is set up through its
+ * registers by configure(). The GPIO pins (alternate function) and the peripheral clocks are
+ * left to the application. When a DMA handle is given, send_async() returns immediately and the
+ * DMA stream interrupt has to be forwarded to the HAL:
+ *
+ * @code
+ * extern "C" void DMA2_Stream7_IRQHandler(void){
+ *     HAL_DMA_IRQHandler(&hdma_usart1_tx);
+ * }
+ * @endcode
+ *
+ * @author Ömer Gökyer
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+#include <array>
+
+#include "LcdTransport.hpp"
+
+/**
+ * @brief Builds the table of lcd_reverse_bits() for every byte value.
+ *
+ * @return The table, evaluated at compile time.
+ */
+constexpr std::array<uint8_t, 256> lcd_reverse_table(){
+
+    std::array<uint8_t, 256> table{};
+    for (uint16_t i = 0; i < table.size(); i++){
+
+        table[i] = lcd_reverse_bits(static_cast<uint8_t>(i));
+    }
+    return table;
+}
+
+/**
+ * @brief Transport that sends LCD data through a USART in synchronous mode.
+ *
+ * The USART runs with 8 data bits, no parity, one stop bit, CPOL low, CPHA on the first edge and
+ * a clock pulse for the last data bit. The start and stop bits are not clocked, so the LCD only
+ * sees the 8 data bits of each byte. RST, CE and DC are plain GPIO outputs assigned with
+ * set_pin().
+ *
+ * The DMA handle, if any, must be initialized for memory to peripheral transfers of bytes with
+ * memory increment, in normal mode, for example DMA2 Stream7 Channel 4 for USART1 TX.
+ *
+ * @usage
+ * __HAL_RCC_USART1_CLK_ENABLE();   // PA9 TX and PA8 CK in AF7
+ * LcdUsartTransport usart(USART1, &hdma_usart1_tx);
+ * usart.configure(4000000);
+ * LcdDriver lcd(usart);
+ * lcd.set_pin(GPIOB, GPIO_PIN_14, LcdLine::RST);
+ */
+class LcdUsartTransport : public LcdGpioTransport {
+
+    public:
+
+        /**
+         * @brief Creates a transport bound to a USART and an optional TX DMA stream.
+         *
+         * @param instance The USART, for example USART1.
+         * @param hdma The initialized TX DMA handle, or nullptr to send with the CPU only.
+         */
+        explicit LcdUsartTransport(USART_TypeDef* instance, DMA_HandleTypeDef* hdma = nullptr) : usart(instance), hdmatx(hdma) {
+
+            if (hdmatx != nullptr){
+
+                hdmatx->Parent = this;
+                hdmatx->XferCpltCallback = &LcdUsartTransport::dma_complete;
+                hdmatx->XferErrorCallback = &LcdUsartTransport::dma_error;
+            }
+        }
+
+        LcdUsartTransport(const LcdUsartTransport&) = delete;
+        LcdUsartTransport& operator=(const LcdUsartTransport&) = delete;
+
+        /**
+         * @brief Sets the USART up as a synchronous transmitter.
+         *
+         * @param clock_hz The CK frequency. The PCD8544 accepts at most 4 MHz; the USART gives at
+         *                 most a sixteenth of its bus clock and at least its bus clock / 65535.
+         * @return True if the USART was set up, false if clock_hz is out of range. The USART is
+         *         left untouched then.
+         */
+        bool configure(uint32_t clock_hz){
+
+            const uint32_t max_clock = 4000000U;
+            uint32_t pclk = (usart == USART1 || usart == USART6) ? HAL_RCC_GetPCLK2Freq() : HAL_RCC_GetPCLK1Freq();
+            if (clock_hz == 0 || clock_hz > max_clock || clock_hz > pclk / 16){
+
+                return false;
+            }
+            uint32_t brr = (pclk + clock_hz / 2) / clock_hz;
+            if (brr > 0xFFFF){
+
+                return false;
+            }
+            usart->CR1 = 0;
+            usart->CR2 = USART_CR2_CLKEN | USART_CR2_LBCL;
+            usart->CR3 = (hdmatx != nullptr) ? USART_CR3_DMAT : 0;
+            usart->BRR = brr;
+            usart->CR1 = USART_CR1_UE | USART_CR1_TE;
+            return true;
+        }
+
+        /**
+         * @brief Sends bytes to the LCD through the USART data register.
+         *
+         * @param data Pointer to the bytes to send.
+         * @param length The number of bytes to send.
+         */
+        void send(const uint8_t* data, uint16_t length) override {
+
+            for (uint16_t n = 0; n < length; n++){
+
+                while ((usart->SR & USART_SR_TXE) == 0){
+                }
+                usart->DR = REVERSED[data[n]];
+            }
+            wait_idle();
+        }
+
+        /**
+         * @brief Bit reverses the bytes into an internal buffer and sends them with DMA.
+         *
+         * Without a DMA handle, or for more than SCRATCH_SIZE bytes, the bytes are sent with
+         * send() and the callback is called directly.
+         *
+         * @param data Pointer to the bytes to send. Free to change once this function returns.
+         * @param length The number of bytes to send.
+         * @param done Function called from the DMA interrupt once the transfer is complete.
+         * @param context Pointer passed back to the done callback.
+         */
+        void send_async(const uint8_t* data, uint16_t length, LcdTransferCallback done, void* context) override {
+
+            failed = false;
+            if (hdmatx != nullptr && length <= SCRATCH_SIZE){
+
+                reverse(data, scratch, length);
+                done_callback = done;
+                done_context = context;
+                in_flight = true;
+                usart->SR = static_cast<uint32_t>(~USART_SR_TC);
+                uint32_t source = static_cast<uint32_t>(reinterpret_cast<uintptr_t>(scratch));
+                uint32_t target = static_cast<uint32_t>(reinterpret_cast<uintptr_t>(&usart->DR));
+                if (HAL_DMA_Start_IT(hdmatx, source, target, length) == HAL_OK){
+
+                    return;
+                }
+                in_flight = false;
+            }
+            LcdTransport::send_async(data, length, done, context);
+        }
+
+        /**
+         * @brief Tells whether a DMA transfer is still in flight.
+         *
+         * @return True until the running transfer has completed.
+         */
+        bool busy() const override {
+
+            return in_flight;
+        }
+
+        /**
+         * @brief Tells whether send_async() uses DMA.
+         *
+         * @return True if a TX DMA handle was given.
+         */
+        bool async_capable() const override {
+
+            return hdmatx != nullptr;
+        }
+
+        /**
+         * @brief Tells whether the last DMA transfer ended with a DMA error.
+         *
+         * @return True if dma_error() ended the last transfer.
+         */
+        bool transfer_failed() const override {
+
+            return failed;
+        }
+
+        /** Largest transfer send_async() can run with DMA: one full frame. */
+        static const uint16_t SCRATCH_SIZE{504};
+
+    private:
+
+        /**
+         * @brief Copies bytes with the bit order of each byte reversed.
+         *
+         * RBIT reverses all 32 bits of a word, which also swaps its bytes; REV swaps them back.
+         *
+         * @param source The bytes to reverse.
+         * @param target Where to write the reversed bytes.
+         * @param length The number of bytes.
+         */
+        static void reverse(const uint8_t* source, uint8_t* target, uint16_t length){
+
+            uint16_t n = 0;
+            for (; n + 4 <= length; n = static_cast<uint16_t>(n + 4)){
+
+                uint32_t word;
+                memcpy(&word, &source[n], sizeof(word));
+                word = __REV(__RBIT(word));
+                memcpy(&target[n], &word, sizeof(word));
+            }
+            for (; n < length; n++){
+
+                target[n] = REVERSED[source[n]];
+            }
+        }
+
+        /**
+         * @brief Waits until the last bit has left the USART.
+         */
+        void wait_idle() const {
+
+            while ((usart->SR & USART_SR_TC) == 0){
+            }
+        }
+
+        /**
+         * @brief DMA completion handler.
+         *
+         * The DMA stream completes once the last byte has been written to the data register, up
+         * to two byte times before the USART has clocked it out, so the handler waits for the
+         * transmission complete flag before CE may be released.
+         *
+         * @param hdma The DMA handle whose Parent is the transport.
+         */
+        static void dma_complete(DMA_HandleTypeDef* hdma){
+
+            LcdUsartTransport* t = static_cast<LcdUsartTransport*>(hdma->Parent);
+            t->wait_idle();
+            t->in_flight = false;
+            if (t->done_callback){
+
+                t->done_callback(t->done_context);
+            }
+        }
+
+        /**
+         * @brief DMA error handler.
+         *
+         * Records the failure for transfer_failed() and ends the transfer without waiting for the
+         * transmission complete flag, which never sets if no byte reached the USART.
+         *
+         * @param hdma The DMA handle whose Parent is the transport.
+         */
+        static void dma_error(DMA_HandleTypeDef* hdma){
+
+            LcdUsartTransport* t = static_cast<LcdUsartTransport*>(hdma->Parent);
+            t->failed = true;
+            t->in_flight = false;
+            if (t->done_callback){
+
+                t->done_callback(t->done_context);
+            }
+        }
+
+        static constexpr std::array<uint8_t, 256> REVERSED = lcd_reverse_table();
+
+        USART_TypeDef* usart;
+        DMA_HandleTypeDef* hdmatx;
+        volatile bool in_flight{false};
+        volatile bool failed{false};
+        LcdTransferCallback done_callback{nullptr};
+        void* done_context{nullptr};
+        alignas(4) uint8_t scratch[SCRATCH_SIZE]{};
+};
@@ -9,6 +9,8 @@
  * @author Ömer Gökyer
  */
 
+#pragma once
+
 #include <stdint.h>
 #include <cstring>
 #include <array>
@@ -33,10 +35,10 @@ struct custom_char {
     }
 };
 
-unsigned char arrow [] = {
+inline unsigned char arrow [] = {
     0x00, 0x08, 0x1c, 0x1c, 0x5d, 0x7f, 0x7f, 0x3e, 0x1c, 0x08, 0x00
 };
-unsigned char gui_array[] = {
+inline unsigned char gui_array[] = {
 	0xf0, 0x3c, 0x06, 0xc2, 0xf3, 0xf3, 0xf9, 0xf9, 0xf9, 0xf9, 0x79, 0x39, 0x19, 0x89, 0x19, 0x39, 
 	0x79, 0xf9, 0xf9, 0xf9, 0xf9, 0xf9, 0xf9, 0xf9, 0xf9, 0xf9, 0xf9, 0xf9, 0xf9, 0xf9, 0xf9, 0xf9, 
 	0xf9, 0xf9, 0xf9, 0xf9, 0xf9, 0xf9, 0xf9, 0xf9, 0xf9, 0xf9, 0xf9, 0xf9, 0xf9, 0xf9, 0xf9, 0xf9, 
@@ -70,7 +72,7 @@ unsigned char gui_array[] = {
 	0x9f, 0x9f, 0x9f, 0x9f, 0x9f, 0x9f, 0x9f, 0x9f, 0x9f, 0x9f, 0x9f, 0x9f, 0x9f, 0x9f, 0x9f, 0x9f, 
 	0x9f, 0x9f, 0xcf, 0xcf, 0x43, 0x60, 0x3c, 0x0f
 };
-unsigned char gui_main_array[] = {
+inline unsigned char gui_main_array[] = {
 	0xf0, 0x3c, 0x06, 0xc2, 0xc3, 0x83, 0x81, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 
 	0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x81, 0x41, 0x21, 
 	0x21, 0xf1, 0x31, 0x11, 0x01, 0xa5, 0xe9, 0xf1, 0xa5, 0xf9, 0xe1, 0xe1, 0xe1, 0x01, 0x01, 0x11, 
@@ -108,8 +110,8 @@ unsigned char gui_main_array[] = {
 /***
  * Custom character instances.
  */
-custom_char arrow_char(11, 8, arrow);
-custom_char menu_gui(84, 48, gui_array);
-custom_char main_gui(84, 48, gui_main_array);
+inline custom_char arrow_char(11, 8, arrow);
+inline custom_char menu_gui(84, 48, gui_array);
+inline custom_char main_gui(84, 48, gui_main_array);
 
 
@@ -4,14 +4,17 @@
  * 
  * This file contains the definition of three fonts: FontMega, FontHuge, and FontLarge.
  * 
- * FontMega is a 16x16 font that requires 24-bit shift data.
+ * FontMega is a 16x32 font, stored as 4 banks per glyph.
  * 
- * FontHuge is a 16x16 font that requires 16-bit shift data.
+ * FontHuge is a 16x24 font, stored as 3 banks per glyph.
  * 
- * FontLarge is a 12x12 font that requires 8-bit shift data.
+ * FontLarge is a 12x16 font, stored as 2 banks per glyph.
  * 
  * These fonts can be used for displaying large characters on a display or screen.
  * 
+ * Each glyph table <Name>Data is converted to bank-major bytes at compile time and wrapped in
+ * an LcdFont descriptor called <Name>, which is what the text functions of LcdDriver take.
+ * 
  * @author Ömer Gökyer
  */
 
@@ -19,12 +22,14 @@
 #include <cstring>
 #include <array>
 
+#include "LcdFont.hpp"
+
 
 /***
- * This font is a 16x16 font. It is used for large characters.
- * This font requires 24 bit shift data.
+ * This font is a 16x32 font. It is used for large characters.
+ * One 32 bit column word per column, converted to 4 banks per glyph.
  */
-static const std::array<std::array<uint32_t, 16>, 13> FontMega = {{
+static constexpr std::array<std::array<uint32_t, 16>, 13> FontMegaData = {{
     {0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x1FC00000, 0x3FE00000, 0x3FE00000, 0x3FE00000, 0x3FE00000, 0x3FE00000, 0x1FC00000, 0x00000000, 0x00000000, 0x00000000, 0x00000000}, // .
     {0x00000000, 0x00000000, 0x00000000, 0x1E000000, 0x07800000, 0x01E00000, 0x00780000, 0x001E0000, 0x00078000, 0x0001E000, 0x00007800, 0x00001E00, 0x00000780, 0x000001E0, 0x00000078, 0x00000000}, // / 
     {0x00000000, 0x3FFFFFF8, 0x7FFFFFFC, 0x7FFFFFFC, 0x7FFFFFFC, 0x7E0000FC, 0x7C00007C, 0x7C00007C, 0x7C00007C, 0x7C00007C, 0x7E0000FC, 0x7FFFFFFC, 0x7FFFFFFC, 0x7FFFFFFC, 0x3FFFFFF8, 0x00000000}, // 0
@@ -41,9 +46,9 @@ static const std::array<std::array<uint32_t, 16>, 13> FontMega = {{
 }};
 
 /***
- * This font requires 16 bit shift data.
+ * This font is a 16x24 font. The low 24 bits of each column word are used, converted to 3 banks per glyph.
  */
-static const std::array<std::array<uint32_t, 16>, 13> FontHuge = {{
+static constexpr std::array<std::array<uint32_t, 16>, 13> FontHugeData = {{
     {0x000000, 0x000000, 0x000000, 0x000000, 0x000000, 0x1FC000, 0x3FE000, 0x3FE000, 0x3FE000, 0x3FE000, 0x3FE000, 0x1FC000, 0x000000, 0x000000, 0x000000, 0x000000}, // .
     {0x000000, 0x000000, 0x000000, 0x000000, 0x000000, 0x000000, 0x000000, 0x000000, 0x000000, 0x000000, 0x000000, 0x000000, 0x000000, 0x000000, 0x000000, 0x000000}, // /
     {0x000000, 0x3FFFFC, 0x7FFFFE, 0x7FFFFE, 0x7FFFFE, 0x7FFFFE, 0x7C003E, 0x7C003E, 0x7C003E, 0x7C003E, 0x7FFFFE, 0x7FFFFE, 0x7FFFFE, 0x7FFFFE, 0x3FFFFC, 0x000000}, // 0
@@ -60,9 +65,9 @@ static const std::array<std::array<uint32_t, 16>, 13> FontHuge = {{
 }};
 
 /***
- * This font requires 8 bit shift data.
+ * This font is a 12x16 font. One 16 bit column word per column, converted to 2 banks per glyph.
  */
-static const std::array<std::array<uint16_t, 12>, 59> FontLarge = {{
+static constexpr std::array<std::array<uint16_t, 12>, 59> FontLargeData = {{
     {0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000}, //
     {0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x39FE, 0x39FE, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000}, // !
     {0x0000, 0x0000, 0x0000, 0x00FC, 0x00FC, 0x0000, 0x0000, 0x00FC, 0x00FC, 0x0000, 0x0000, 0x0000}, // "
@@ -124,7 +129,7 @@ static const std::array<std::array<uint16_t, 12>, 59> FontLarge = {{
     {0x0000, 0x1C06, 0x3E07, 0x3F07, 0x3B87, 0x39C7, 0x38E7, 0x3877, 0x383F, 0x381F, 0x180E, 0x0000} // Z
 }};
 
-static const std::array<std::array<uint8_t, 5>, 94> FontDefault = {{
+static constexpr std::array<std::array<uint8_t, 5>, 94> FontDefaultData = {{
     {0x00, 0x00, 0x00, 0x00, 0x00}, // 20
     {0x00, 0x00, 0x5f, 0x00, 0x00}, // 21 ! 
     {0x00, 0x07, 0x00, 0x07, 0x00}, // 22 ?
@@ -221,7 +226,7 @@ static const std::array<std::array<uint8_t, 5>, 94> FontDefault = {{
     {0x00, 0x41, 0x36, 0x08, 0x00}, // 7d },
 }};
 
-static const std::array<std::array<uint8_t, 7>, 59> FontThick = {{
+static constexpr std::array<std::array<uint8_t, 7>, 59> FontThickData = {{
     {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}, //  
     {0x5f, 0x5f, 0x00, 0x00, 0x00, 0x00, 0x00}, // !
     {0x07, 0x07, 0x00, 0x07, 0x07, 0x00, 0x00}, // "
@@ -283,7 +288,7 @@ static const std::array<std::array<uint8_t, 7>, 59> FontThick = {{
     {0x73, 0x7b, 0x6b, 0x6b, 0x6b, 0x6f, 0x67}, // Z
 }};
 
-static const std::array<std::array<uint8_t, 7>, 95> FontHomeSpun = {{
+static constexpr std::array<std::array<uint8_t, 7>, 95> FontHomeSpunData = {{
     {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}, //  
     {0x00, 0x00, 0x00, 0x5f, 0x00, 0x00, 0x00}, // !
     {0x03, 0x00, 0x03, 0x00, 0x00, 0x00, 0x00}, // "
@@ -381,7 +386,7 @@ static const std::array<std::array<uint8_t, 7>, 95> FontHomeSpun = {{
     {0x1c, 0x04, 0x1c, 0x10, 0x1c, 0x00, 0x00} // ~
 }};
 
-static const std::array<std::array<uint8_t, 4>, 92> FontSevenSegment = {{
+static constexpr std::array<std::array<uint8_t, 4>, 92> FontSevenSegmentData = {{
     {0x00, 0x00, 0x00, 0x00}, //  
     {0x36, 0x00, 0x00, 0x00}, // !
     {0x06, 0x00, 0x00, 0x06}, // "
@@ -475,7 +480,7 @@ static const std::array<std::array<uint8_t, 4>, 92> FontSevenSegment = {{
     {0x30, 0x49, 0x49, 0x06}, // z
 }};
 
-static const std::array<std::array<uint8_t, 8>, 59> FontWide = {{
+static constexpr std::array<std::array<uint8_t, 8>, 59> FontWideData = {{
     {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}, //  
     {0x00, 0x00, 0x00, 0x5f, 0x00, 0x00, 0x00, 0x00}, // !
     {0x00, 0x03, 0x00, 0x03, 0x00, 0x00, 0x00, 0x00}, // "
@@ -537,7 +542,7 @@ static const std::array<std::array<uint8_t, 8>, 59> FontWide = {{
     {0x00, 0x71, 0x49, 0x49, 0x49, 0x49, 0x49, 0x47}, // Z
 }};
 
-static const std::array<std::array<uint8_t, 3>, 95> FontTiny = {{
+static constexpr std::array<std::array<uint8_t, 3>, 95> FontTinyData = {{
     {0x00, 0x00, 0x00}, //  
     {0x00, 0x2e, 0x00}, // !
     {0x06, 0x00, 0x06}, // "
@@ -635,7 +640,7 @@ static const std::array<std::array<uint8_t, 3>, 95> FontTiny = {{
     {0x02, 0x06, 0x04} // ~
 }};
 
-static const std::array<std::array<uint8_t, 6>, 96> Default = {{
+static constexpr std::array<std::array<uint8_t, 6>, 96> DefaultData = {{
  {0x00, 0x00, 0x00, 0x00, 0x00, 0x00} // 20   
 ,{0x00, 0x00, 0x00, 0x5f, 0x00, 0x00} // 21 ! 
 ,{0x00, 0x00, 0x07, 0x00, 0x07, 0x00} // 22 " 
@@ -732,4 +737,34 @@ static const std::array<std::array<uint8_t, 6>, 96> Default = {{
 ,{0x00, 0x00, 0x41, 0x36, 0x08, 0x00} // 7d } 
 ,{0x00, 0x10, 0x08, 0x08, 0x10, 0x08} // 7e â†�
 ,{0x00, 0x78, 0x46, 0x41, 0x46, 0x78} // 7f â†’
-}};
\ No newline at end of file
+}};
+
+
+/***
+ * Font descriptors taken by LcdDriver::print() and LcdDriver::print_buffer().
+ *
+ * The tables above are only read by the compiler: lcd_font_banks() turns them into bank-major
+ * byte glyphs, which is what the descriptors point to. FontHuge is 24 pixels high and keeps
+ * 3 of the 4 bytes of each column.
+ */
+static constexpr auto FontMegaBanks = lcd_font_banks<32>(FontMegaData);
+static constexpr auto FontHugeBanks = lcd_font_banks<24>(FontHugeData);
+static constexpr auto FontLargeBanks = lcd_font_banks<16>(FontLargeData);
+static constexpr auto FontDefaultBanks = lcd_font_banks<8>(FontDefaultData);
+static constexpr auto FontThickBanks = lcd_font_banks<8>(FontThickData);
+static constexpr auto FontHomeSpunBanks = lcd_font_banks<8>(FontHomeSpunData);
+static constexpr auto FontSevenSegmentBanks = lcd_font_banks<8>(FontSevenSegmentData);
+static constexpr auto FontWideBanks = lcd_font_banks<8>(FontWideData);
+static constexpr auto FontTinyBanks = lcd_font_banks<8>(FontTinyData);
+static constexpr auto DefaultBanks = lcd_font_banks<8>(DefaultData);
+
+static constexpr LcdBankFont<16, 13, '.', 32> FontMega{FontMegaBanks};
+static constexpr LcdBankFont<16, 13, '.', 24> FontHuge{FontHugeBanks};
+static constexpr LcdBankFont<12, 59, ' ', 16> FontLarge{FontLargeBanks};
+static constexpr LcdBankFont<5, 94, ' ', 8> FontDefault{FontDefaultBanks};
+static constexpr LcdBankFont<7, 59, ' ', 8> FontThick{FontThickBanks};
+static constexpr LcdBankFont<7, 95, ' ', 8> FontHomeSpun{FontHomeSpunBanks};
+static constexpr LcdBankFont<4, 92, ' ', 8> FontSevenSegment{FontSevenSegmentBanks};
+static constexpr LcdBankFont<8, 59, ' ', 8> FontWide{FontWideBanks};
+static constexpr LcdBankFont<3, 95, ' ', 8> FontTiny{FontTinyBanks};
+static constexpr LcdBankFont<6, 96, ' ', 8> Default{DefaultBanks};
@@ -0,0 +1,87 @@
+
+/**
+ * @file projectExamples.hpp
+ * @brief This file contains the example screens and the reference wiring.
+ *
+ * Shared by the firmware (projectMain.cpp) and the host build (Host/Src/host_main.cpp), so both
+ * draw exactly the same screens.
+ *
+ * @author Ömer Gökyer
+ */
+
+#pragma once
+
+#include "LcdDriver.hpp"
+#include "LcdBsrrTransport.hpp"
+
+/**
+ * @brief Reference wiring: every LCD line on GPIOB, driven through BSRR.
+ */
+using LcdBus = LcdBsrrTransport<
+    LcdPin<LcdPort::B, GPIO_PIN_14>,    // RST
+    LcdPin<LcdPort::B, GPIO_PIN_13>,    // CE
+    LcdPin<LcdPort::B, GPIO_PIN_12>,    // DC
+    LcdPin<LcdPort::B, GPIO_PIN_10>,    // DIN
+    LcdPin<LcdPort::B, GPIO_PIN_11>>;   // CLK
+
+/**
+ * @brief Draws one of the example screens.
+ *
+ * @param lcd The LCD to draw on.
+ * @param num The screen number, 0 to 4.
+ */
+inline void print_examples(LcdDriver& lcd, int num) {
+
+    LcdDriver::Frame frame(lcd);    // draw the whole screen, flush once
+    switch (num)
+    {
+    case 0:
+        lcd.clear();
+        lcd.put_char_xy(main_gui, 0, 0);
+        break;
+    
+    case 1:
+        lcd.clear();
+        lcd.put_char_xy(menu_gui, 0, 0);
+        lcd.put_char_xy(arrow_char, 6, 20);
+        lcd.print_buffer("Omer", 20, 20, Default);
+        lcd.invert(true);
+        lcd.print_buffer("ben0mer", 21, 6, FontDefault);
+        lcd.print_buffer("Gokyer", 21, 36, FontDefault);
+        lcd.invert(false);
+        break;
+
+    case 2:
+        lcd.clear();
+        lcd.put_char_xy(menu_gui, 0, 0);
+        lcd.put_char_xy(arrow_char, 6, 20);
+        lcd.print_buffer("ben0mer", 20, 20, Default);
+        lcd.invert(true);
+        lcd.print_buffer("GitHub", 21, 6, FontDefault);
+        lcd.print_buffer("Omer", 21, 36, FontDefault);
+        lcd.invert(false);
+        break;
+
+    case 3:
+        lcd.clear();
+        lcd.put_char_xy(menu_gui, 0, 0);
+        lcd.put_char_xy(arrow_char, 6, 20);
+        lcd.print_buffer("GitHub", 20, 20, Default);
+        lcd.invert(true);
+        lcd.print_buffer("Gokyer", 21, 6, FontDefault);
+        lcd.print_buffer("ben0mer", 21, 36, FontDefault);
+        lcd.invert(false);
+        break;
+
+    case 4:
+        lcd.clear();
+        lcd.put_char_xy(menu_gui, 0, 0);
+        lcd.put_char_xy(arrow_char, 6, 20);
+        lcd.print_buffer("Gokyer", 20, 20, Default);
+        lcd.invert(true);
+        lcd.print_buffer("Omer", 21, 6, FontDefault);
+        lcd.print_buffer("GitHub", 21, 36, FontDefault);
+        lcd.invert(false);
+        break;
+    }
+}
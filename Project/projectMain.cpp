@@ -8,89 +8,52 @@
 
 #include "main.h"
 #include <Project/projectMain.h>
-#include <Project/LcdDriver.hpp>
-
-LcdDriver lcd; 
-
-void print_examples(int num) {
-
-    switch (num)
-    {
-    case 0:
-        lcd.clear();
-        lcd.put_char_xy(main_gui, 0, 0);
-        break;
-    
-    case 1:
-        lcd.clear();
-        lcd.put_char_xy(menu_gui, 0, 0);
-        lcd.put_char_xy(arrow_char, 6, 20);
-        lcd.print_buffer("Omer", 20, 20, Default);
-        lcd.invert(true);
-        lcd.print_buffer("ben0mer", 21, 6, FontDefault);
-        lcd.print_buffer("Gokyer", 21, 36, FontDefault);
-        lcd.invert(false);
-        break;
-
-    case 2:
-        lcd.clear();
-        lcd.put_char_xy(menu_gui, 0, 0);
-        lcd.put_char_xy(arrow_char, 6, 20);
-        lcd.print_buffer("ben0mer", 20, 20, Default);
-        lcd.invert(true);
-        lcd.print_buffer("GitHub", 21, 6, FontDefault);
-        lcd.print_buffer("Omer", 21, 36, FontDefault);
-        lcd.invert(false);
-        break;
-
-    case 3:
-        lcd.clear();
-        lcd.put_char_xy(menu_gui, 0, 0);
-        lcd.put_char_xy(arrow_char, 6, 20);
-        lcd.print_buffer("GitHub", 20, 20, Default);
-        lcd.invert(true);
-        lcd.print_buffer("Gokyer", 21, 6, FontDefault);
-        lcd.print_buffer("ben0mer", 21, 36, FontDefault);
-        lcd.invert(false);
-        break;
-
-    case 4:
-        lcd.clear();
-        lcd.put_char_xy(menu_gui, 0, 0);
-        lcd.put_char_xy(arrow_char, 6, 20);
-        lcd.print_buffer("Gokyer", 20, 20, Default);
-        lcd.invert(true);
-        lcd.print_buffer("Omer", 21, 6, FontDefault);
-        lcd.print_buffer("GitHub", 21, 36, FontDefault);
-        lcd.invert(false);
-        break;
-    }
-}
+#include <Project/projectExamples.hpp>
+
+/**
+ * Set to 1 to drive the LCD through SPI2 and its TX DMA stream instead of LcdBus. SPI2 takes
+ * PB13 (CLK) and PB15 (DIN), so CE moves to PB12 and DC to PB11; RST stays on PB14.
+ */
+#ifndef LCD_TRANSPORT_SPI
+#define LCD_TRANSPORT_SPI 0
+#endif
+
+#if LCD_TRANSPORT_SPI
+#include "dma.h"
+#include "spi.h"
+#include <Project/LcdSpiTransport.hpp>
+
+LcdSpiTransport lcd_bus(&hspi2);
+#else
+LcdBus lcd_bus;
+#endif
+LcdDriver lcd(lcd_bus);
 
 void projectMain()
 {
 
-    lcd.set_pin(GPIOB, GPIO_PIN_14, "RST");
-    lcd.set_pin(GPIOB, GPIO_PIN_13, "CE");
-    lcd.set_pin(GPIOB, GPIO_PIN_12, "DC");
-    lcd.set_pin(GPIOB, GPIO_PIN_10, "DIN");
-    lcd.set_pin(GPIOB, GPIO_PIN_11, "CLK");
-
+#if LCD_TRANSPORT_SPI
+    MX_DMA_Init();
+    MX_SPI2_Init();
+    lcd.set_pin(GPIOB, GPIO_PIN_14, LcdLine::RST);
+    lcd.set_pin(GPIOB, GPIO_PIN_12, LcdLine::CE);
+    lcd.set_pin(GPIOB, GPIO_PIN_11, LcdLine::DC);
+#endif
     lcd.init();
 
     while (true)
     {
-        print_examples(0);
+        print_examples(lcd, 0);
         HAL_Delay(2000);
-        print_examples(1);
+        print_examples(lcd, 1);
         HAL_Delay(2000);
-        print_examples(2);
+        print_examples(lcd, 2);
         HAL_Delay(2000);
-        print_examples(3);
+        print_examples(lcd, 3);
         HAL_Delay(2000);
-        print_examples(4);
+        print_examples(lcd, 4);
         HAL_Delay(2000);
-        print_examples(1);
+        print_examples(lcd, 1);
         HAL_Delay(2000);
     }
 }
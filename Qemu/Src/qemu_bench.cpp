@@ -0,0 +1,254 @@
+
+/**
+ * @file qemu_bench.cpp
+ * @brief On-target benchmark image of the rendering and flush kernels.
+ *
+ * Runs the kernels of LcdDriver on the Cortex-M4 and prints the cost of each one through ARM
+ * semihosting, so the same image reports on a board with a debugger attached and under QEMU:
+ *
+ *   qemu-system-arm -machine netduinoplus2 -nographic -monitor none -serial none \
+ *       -semihosting-config enable=on,target=native -icount shift=0 -kernel lcd-qemu-bench.elf
+ *
+ * The counter is picked at startup:
+ * - On silicon the DWT cycle counter runs and the figures are core clock cycles, including flash
+ *   wait states and bus stalls.
+ * - QEMU does not model DWT. The image then times with SysTick, which under -icount advances a
+ *   fixed amount per executed instruction, and calibrates it against a loop of known length. The
+ *   figures are executed instructions: reproducible and sensitive to Thumb-2 code generation,
+ *   but without wait states or pipeline stalls.
+ *
+ * GPIO writes of the bit-banged transport go to the GPIO block, which QEMU accepts and ignores.
+ * The output is JSON in the layout of the host lcd-bench, with "count_per_op" in place of
+ * "ns_per_op".
+ *
+ * @author Ömer Gökyer
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "Host/Inc/LcdCountingTransport.hpp"
+#include "Project/LcdDriver.hpp"
+#include "Project/projectExamples.hpp"
+
+extern "C" void initialise_monitor_handles(void);
+
+/* Calls per measurement, and measurements per case; the lowest one is reported. */
+static const uint32_t ITERATIONS = 32;
+static const uint32_t REPEATS = 3;
+
+static volatile uint32_t systick_wraps = 0;
+
+extern "C" void SysTick_Handler(void){
+
+    systick_wraps = systick_wraps + 1;
+}
+
+/**
+ * @brief Cycle counter of the benchmarks: DWT->CYCCNT on silicon, calibrated SysTick on QEMU.
+ */
+class BenchCounter {
+
+    public:
+
+        /**
+         * @brief Starts the counter.
+         *
+         * @return True if DWT counts cycles, false if the SysTick fallback is used.
+         */
+        static bool start(){
+
+            SET_BIT(CoreDebug->DEMCR, CoreDebug_DEMCR_TRCENA_Msk);
+            DWT->CYCCNT = 0;
+            SET_BIT(DWT->CTRL, DWT_CTRL_CYCCNTENA_Msk);
+            spin(100);
+            dwt = DWT->CYCCNT != 0;
+            if (dwt){
+
+                return true;
+            }
+
+            SysTick->LOAD = SysTick_LOAD_RELOAD_Msk;
+            SysTick->VAL = 0;
+            SysTick->CTRL = SysTick_CTRL_CLKSOURCE_Msk | SysTick_CTRL_TICKINT_Msk | SysTick_CTRL_ENABLE_Msk;
+
+            /* Two instructions per pass of spin(): subs and bne. */
+            const uint32_t passes = 200000;
+            uint64_t begin = now();
+            spin(passes);
+            ticks_per_kilo_insn = static_cast<uint32_t>((now() - begin) * 1000 / (2 * passes));
+            if (ticks_per_kilo_insn == 0){
+
+                ticks_per_kilo_insn = 1;
+            }
+            return false;
+        }
+
+        /**
+         * @brief Returns the raw counter value.
+         */
+        static uint64_t now(){
+
+            if (dwt){
+
+                return DWT->CYCCNT;
+            }
+            uint32_t wraps;
+            uint32_t value;
+            do {
+
+                wraps = systick_wraps;
+                value = SysTick->VAL;
+            } while (wraps != systick_wraps);
+            return (static_cast<uint64_t>(wraps) << 24) | (SysTick_LOAD_RELOAD_Msk - value);
+        }
+
+        /**
+         * @brief Converts a counter difference into cycles (DWT) or instructions (SysTick).
+         */
+        static uint32_t elapsed(uint64_t begin, uint64_t end){
+
+            if (dwt){
+
+                return static_cast<uint32_t>(end) - static_cast<uint32_t>(begin);
+            }
+            return static_cast<uint32_t>((end - begin) * 1000 / ticks_per_kilo_insn);
+        }
+
+        static const char* unit(){
+
+            return dwt ? "dwt_cycles" : "qemu_instructions";
+        }
+
+    private:
+
+        static void spin(uint32_t passes){
+
+            __asm volatile("1: subs %0, %0, #1\n\tbne 1b" : "+r"(passes) : : "cc");
+        }
+
+        static inline bool dwt{false};
+        static inline uint32_t ticks_per_kilo_insn{1};
+};
+
+static bool first_result = true;
+
+/**
+ * @brief Measures a case and prints its JSON line.
+ *
+ * @param op Callable that performs ops_per_call operations.
+ * @param bytes_per_frame Bytes one call puts on the bus, or -1 if the kernel does not send.
+ */
+template <typename Op>
+static void run(const char* kernel, const char* variant, int y_align, const char* unit,
+                uint32_t ops_per_call, long bytes_per_frame, Op&& op){
+
+    uint32_t best = 0;
+    for (uint32_t r = 0; r < REPEATS; r++){
+
+        uint64_t begin = BenchCounter::now();
+        for (uint32_t i = 0; i < ITERATIONS; i++){
+
+            op();
+        }
+        uint32_t count = BenchCounter::elapsed(begin, BenchCounter::now());
+        if (r == 0 || count < best){
+
+            best = count;
+        }
+    }
+    uint32_t per_op = best / (ITERATIONS * ops_per_call);
+    printf("%s    {\"kernel\": \"%s\", \"variant\": \"%s\", \"y_align\": %d, \"unit\": \"%s\", "
+           "\"count_per_op\": %lu, \"bytes_per_frame\": ",
+           first_result ? "" : ",\n", kernel, variant, y_align, unit, static_cast<unsigned long>(per_op));
+    if (bytes_per_frame < 0){
+
+        printf("null}");
+    }
+    else {
+
+        printf("%ld}", bytes_per_frame);
+    }
+    first_result = false;
+}
+
+static void bench_rendering(){
+
+    static const char text[] = "0123456789";
+    static LcdCountingTransport bus;
+    static LcdDriver lcd(bus);
+    lcd.set_flush_policy(LcdFlushPolicy::Manual);
+
+    for (uint8_t align = 0; align < 8; align++){
+
+        const uint8_t y = static_cast<uint8_t>(8 + align);
+        run("print_buffer", "FontDefault", align, "glyph", 10, -1, [&]{
+
+            lcd.print_buffer(text, 0, y, FontDefault);
+        });
+        run("print_buffer", "FontTiny", align, "glyph", 10, -1, [&]{
+
+            lcd.print_buffer(text, 0, y, FontTiny);
+        });
+        run("put_char_xy", "arrow_char", align, "glyph", 1, -1, [&]{
+
+            lcd.put_char_xy(arrow_char, 20, y);
+        });
+        run("clear_area", "8x8", align, "call", 1, -1, [&]{
+
+            lcd.clear_area(38, y, 8, 8);
+        });
+    }
+    run("print", "FontDefault", 0, "glyph", 10, -1, [&]{
+
+        lcd.print(text, 0, 1, FontDefault);
+    });
+    run("print", "FontMega", 0, "glyph", 5, -1, [&]{
+
+        lcd.print("12345", 0, 1, FontMega);
+    });
+}
+
+static void bench_flush(){
+
+    static LcdCountingTransport counting;
+    static LcdDriver null_lcd(counting);
+    null_lcd.init();
+    run("refresh_screen", "null_transport", -1, "frame", 1, 506, [&]{
+
+        null_lcd.refresh_screen();
+    });
+
+    /* The bit-banged transport of the examples; its GPIO stores are ignored by QEMU. */
+    static LcdBus bsrr;
+    static LcdDriver lcd(bsrr);
+    lcd.init();
+    run("refresh_screen", "LcdBsrrTransport", -1, "frame", 1, 506, [&]{
+
+        lcd.refresh_screen();
+    });
+
+    lcd.set_flush_policy(LcdFlushPolicy::Manual);
+    counting.reset();
+    null_lcd.set_flush_policy(LcdFlushPolicy::Manual);
+    null_lcd.print_buffer("42", 60, 0, FontDefault);
+    null_lcd.refresh_dirty();
+    long label_bytes = static_cast<long>(counting.total_bytes());
+    run("refresh_dirty", "LcdBsrrTransport", 0, "frame", 1, label_bytes, [&]{
+
+        lcd.print_buffer("42", 60, 0, FontDefault);
+        lcd.refresh_dirty();
+    });
+}
+
+int main(void){
+
+    initialise_monitor_handles();
+    BenchCounter::start();
+    printf("{\n  \"benchmark\": \"lcd-qemu-bench\",\n  \"counter\": \"%s\",\n  \"framebuffers\": %d,\n  \"results\": [\n",
+           BenchCounter::unit(), LCD_FRAMEBUFFER_COUNT);
+    bench_rendering();
+    bench_flush();
+    printf("\n  ]\n}\n");
+    exit(0);
+}